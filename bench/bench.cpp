@@ -0,0 +1,824 @@
+#include "ChunkManager.h"
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <vector>
+#include <filesystem>
+#include <random>
+
+// Headless micro-benchmarks on fixed seeds; nothing here opens a window or touches GL, and the
+// bench links without raylib. Results are printed as CSV (benchmark,value,unit) so runs can be
+// diffed; the exit code is non-zero when any correctness check found a mismatch.
+static const int GridSize = 32;
+static const int Layers = 2;
+
+static double SecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+static int failedChecks = 0;
+static void Report(const char* name, double value, const char* unit)
+{
+    printf("%s,%.3f,%s\n", name, value, unit);
+}
+// A correctness check: reported like any result, and counted as failed when count is non-zero.
+static void ReportMismatches(const char* name, int count, const char* unit)
+{
+    Report(name, count, unit);
+    if (count != 0) failedChecks++;
+}
+struct DenseVoxels
+{
+    unsigned char voxels[CHUNK_SIZE][CHUNK_SIZE][CHUNK_SIZE];
+};
+static bool MatchesDense(const Chunk& chunk, const DenseVoxels& dense)
+{
+    DenseVoxels expanded;
+    chunk.voxels.CopyTo(expanded.voxels);
+    return memcmp(expanded.voxels, dense.voxels, sizeof(dense.voxels)) == 0;
+}
+// The generator as it was before heightmaps: one stb call per column per layer, one compare per voxel.
+static void GenerateReference(DenseVoxels& chunk, int cx, int cy, int cz)
+{
+    for (int x = 0; x < CHUNK_SIZE; x++)
+    {
+        for (int z = 0; z < CHUNK_SIZE; z++)
+        {
+            float worldX = (float)(cx * CHUNK_SIZE + x);
+            float worldZ = (float)(cz * CHUNK_SIZE + z);
+            float noise = stb_perlin_noise3(worldX * 0.03f, 0.0f, worldZ * 0.03f, 0, 0, 0);
+            int worldHeight = (int)(8 + noise * 10);
+            for (int y = 0; y < CHUNK_SIZE; y++)
+            {
+                float worldY = (float)(cy * CHUNK_SIZE + y);
+                chunk.voxels[x][y][z] = (worldY < worldHeight) ? 1 : 0;
+            }
+        }
+    }
+}
+static void GenerateGrid(std::vector<Chunk>& chunks, TerrainGenerator& generator)
+{
+    for (int cx = 0; cx < GridSize; cx++)
+    {
+        for (int cz = 0; cz < GridSize; cz++)
+        {
+            for (int cy = 0; cy < Layers; cy++)
+            {
+                chunks[(cx * GridSize + cz) * Layers + cy].GenerateData(cx, cy, cz, generator);
+            }
+        }
+    }
+}
+static void BenchGeneration()
+{
+    std::vector<DenseVoxels> reference(GridSize * GridSize * Layers);
+    std::vector<Chunk> generated(GridSize * GridSize * Layers);
+    const int rounds = 5;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++)
+    {
+        for (int cx = 0; cx < GridSize; cx++)
+        {
+            for (int cz = 0; cz < GridSize; cz++)
+            {
+                for (int cy = 0; cy < Layers; cy++)
+                {
+                    GenerateReference(reference[(cx * GridSize + cz) * Layers + cy], cx, cy, cz);
+                }
+            }
+        }
+    }
+    Report("generate_reference", rounds * reference.size() / SecondsSince(start), "chunks/s");
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++)
+    {
+        std::unique_ptr<TerrainGenerator> generator = TerrainGenerator::CreateClassic();
+        GenerateGrid(generated, *generator);
+    }
+    Report("generate", rounds * generated.size() / SecondsSince(start), "chunks/s");
+    int mismatches = 0;
+    for (size_t i = 0; i < generated.size(); i++)
+    {
+        if (!MatchesDense(generated[i], reference[i])) mismatches++;
+    }
+    ReportMismatches("generate_mismatches", mismatches, "chunks");
+    Report("noise_lanes", TERRAIN_NOISE_LANES, "floats");
+    TerrainSettings settings;
+    settings.seed = 1337;
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++)
+    {
+        std::unique_ptr<TerrainGenerator> generator = TerrainGenerator::CreateDefault(settings);
+        GenerateGrid(generated, *generator);
+    }
+    Report("generate_pipeline", rounds * generated.size() / SecondsSince(start), "chunks/s");
+    int uniform = 0;
+    size_t resident = 0;
+    for (const Chunk& chunk : generated)
+    {
+        if (chunk.voxels.GetMode() == VoxelStorage::Mode::Uniform) uniform++;
+        resident += chunk.voxels.ResidentBytes();
+    }
+    Report("voxel_uniform_chunks", uniform * 100.0 / generated.size(), "%");
+    Report("voxel_bytes_per_chunk", (double)resident / generated.size(), "bytes");
+}
+// Saves a generated grid through the async writer, then loads it back through a fresh store so
+// every region is mapped cold, and compares against generating the same chunks.
+static void BenchPersistence()
+{
+    std::vector<Chunk> source(GridSize * GridSize * Layers);
+    std::vector<DenseVoxels> loaded(GridSize * GridSize * Layers);
+    TerrainSettings settings;
+    settings.seed = 1337;
+    std::unique_ptr<TerrainGenerator> generator = TerrainGenerator::CreateDefault(settings);
+    GenerateGrid(source, *generator);
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "voxel_bench_regions";
+    std::filesystem::remove_all(directory);
+    {
+        RegionStore store(directory.string());
+        auto start = std::chrono::steady_clock::now();
+        for (int cx = 0; cx < GridSize; cx++)
+        {
+            for (int cz = 0; cz < GridSize; cz++)
+            {
+                for (int cy = 0; cy < Layers; cy++)
+                {
+                    DenseVoxels expanded;
+                    source[(cx * GridSize + cz) * Layers + cy].voxels.CopyTo(expanded.voxels);
+                    store.SaveAsync({cx, cy, cz}, expanded.voxels);
+                }
+            }
+        }
+        Report("save_enqueue", source.size() / SecondsSince(start), "chunks/s");
+        store.Flush();
+        Report("save_flush", source.size() / SecondsSince(start), "chunks/s");
+    }
+    uintmax_t bytes = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) bytes += entry.file_size();
+    Report("region_bytes_per_chunk", (double)bytes / source.size(), "bytes");
+    const int rounds = 5;
+    int mismatches = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++)
+    {
+        RegionStore store(directory.string());
+        for (int cx = 0; cx < GridSize; cx++)
+        {
+            for (int cz = 0; cz < GridSize; cz++)
+            {
+                for (int cy = 0; cy < Layers; cy++)
+                {
+                    if (!store.Load({cx, cy, cz}, loaded[(cx * GridSize + cz) * Layers + cy].voxels)) mismatches++;
+                }
+            }
+        }
+    }
+    Report("load", rounds * loaded.size() / SecondsSince(start), "chunks/s");
+    for (size_t i = 0; i < loaded.size(); i++)
+    {
+        if (!MatchesDense(source[i], loaded[i])) mismatches++;
+    }
+    ReportMismatches("load_mismatches", mismatches, "chunks");
+    // Each chunk edited twice and loaded straight back, before the save thread can have written
+    // it: the load has to return the second edit, not the copy in the file.
+    {
+        RegionStore store(directory.string());
+        int stale = 0;
+        for (size_t i = 0; i < source.size(); i++)
+        {
+            ChunkPos pos = {(int)(i / (Layers * GridSize)), (int)(i % Layers), (int)(i / Layers % GridSize)};
+            DenseVoxels edited;
+            DenseVoxels reloaded;
+            source[i].voxels.CopyTo(edited.voxels);
+            edited.voxels[0][0][0] = edited.voxels[0][0][0] == 0 ? 1 : 0;
+            store.SaveAsync(pos, edited.voxels);
+            edited.voxels[1][0][0] = edited.voxels[1][0][0] == 0 ? 1 : 0;
+            store.SaveAsync(pos, edited.voxels);
+            if (!store.Load(pos, reloaded.voxels) || memcmp(reloaded.voxels, edited.voxels, sizeof(edited.voxels)) != 0) stale++;
+        }
+        ReportMismatches("load_pending_mismatches", stale, "chunks");
+    }
+    std::filesystem::remove_all(directory);
+}
+// Plain DDA with a chunk map lookup per voxel, used as the correctness and speed baseline.
+static VoxelRayHit RaycastReference(ChunkManager& world, Float3 origin, Float3 direction, float maxDistance)
+{
+    VoxelRayHit result;
+    float length = sqrtf(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+    const float start[3] = {origin.x, origin.y, origin.z};
+    const float dir[3] = {direction.x / length, direction.y / length, direction.z / length};
+    int voxel[3], step[3];
+    float tMax[3], tDelta[3];
+    for (int a = 0; a < 3; a++)
+    {
+        voxel[a] = (int)floorf(start[a]);
+        step[a] = dir[a] > 0.0f ? 1 : (dir[a] < 0.0f ? -1 : 0);
+        tDelta[a] = step[a] != 0 ? fabsf(1.0f / dir[a]) : INFINITY;
+        tMax[a] = step[a] != 0 ? (step[a] > 0 ? voxel[a] + 1.0f - start[a] : start[a] - voxel[a]) * tDelta[a] : INFINITY;
+    }
+    float t = 0.0f;
+    while (t <= maxDistance)
+    {
+        if (world.GetBlock(voxel[0], voxel[1], voxel[2]) != 0)
+        {
+            result.hit = true;
+            result.x = voxel[0];
+            result.y = voxel[1];
+            result.z = voxel[2];
+            result.distance = t;
+            return result;
+        }
+        int a = tMax[0] < tMax[1] ? (tMax[0] < tMax[2] ? 0 : 2) : (tMax[1] < tMax[2] ? 1 : 2);
+        t = tMax[a];
+        voxel[a] += step[a];
+        tMax[a] += tDelta[a];
+    }
+    return result;
+}
+// Rays from above the terrain looking down, and level rays at terrain height for line of sight.
+static void BenchRaycast(ChunkManager& world)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<Ray3> rays(1 << 16);
+    for (size_t i = 0; i < rays.size(); i++)
+    {
+        Float3 origin = {128.0f + 96.0f * unit(rng), (i & 1) ? 40.0f : 18.0f, 128.0f + 96.0f * unit(rng)};
+        Float3 direction = {unit(rng), (i & 1) ? -fabsf(unit(rng)) - 0.1f : 0.2f * unit(rng), unit(rng)};
+        rays[i] = {origin, direction};
+    }
+    const float maxDistance = 96.0f;
+    std::vector<VoxelRayHit> expected(rays.size());
+    std::vector<VoxelRayHit> hits(rays.size());
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rays.size(); i++) expected[i] = RaycastReference(world, rays[i].position, rays[i].direction, maxDistance);
+    Report("raycast_reference", rays.size() / SecondsSince(start), "rays/s");
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rays.size(); i++) hits[i] = world.Raycast(rays[i].position, rays[i].direction, maxDistance);
+    Report("raycast", rays.size() / SecondsSince(start), "rays/s");
+    int mismatches = 0;
+    int hitCount = 0;
+    for (size_t i = 0; i < rays.size(); i++)
+    {
+        if (hits[i].hit != expected[i].hit || hits[i].x != expected[i].x || hits[i].y != expected[i].y || hits[i].z != expected[i].z) mismatches++;
+        if (hits[i].hit) hitCount++;
+    }
+    Report("raycast_hits", hitCount * 100.0 / rays.size(), "%");
+    ReportMismatches("raycast_mismatches", mismatches, "rays");
+}
+// The naive mesher as it was before solid-column bitmasks: a bounds-checked byte read for the
+// face and each of its 12 AO neighbors, with the offsets converted from float tables every time.
+// Standard vertices at LOD 0 only.
+static bool IsSolidReference(const unsigned char voxels[CHUNK_SIZE + 2][CHUNK_SIZE + 2][CHUNK_SIZE + 2], int x, int y, int z)
+{
+    if (x < 0 || x >= CHUNK_SIZE + 2 || y < 0 || y >= CHUNK_SIZE + 2 || z < 0 || z >= CHUNK_SIZE + 2) return false;
+    return voxels[x][y][z] != 0;
+}
+static void BuildNaiveReference(const unsigned char voxels[CHUNK_SIZE + 2][CHUNK_SIZE + 2][CHUNK_SIZE + 2], ChunkMeshData& out)
+{
+    out.Clear();
+    for (int x = 1; x <= CHUNK_SIZE; x++)
+    {
+        for (int y = 1; y <= CHUNK_SIZE; y++)
+        {
+            for (int z = 1; z <= CHUNK_SIZE; z++)
+            {
+                if (voxels[x][y][z] == 0) continue;
+                for (int f = 0; f < 6; f++)
+                {
+                    int nx = x + (int)VoxelData::FaceChecks[f].x;
+                    int ny = y + (int)VoxelData::FaceChecks[f].y;
+                    int nz = z + (int)VoxelData::FaceChecks[f].z;
+                    if (IsSolidReference(voxels, nx, ny, nz)) continue;
+                    int ao[4];
+                    for (int v = 0; v < 4; v++)
+                    {
+                        Float3 s1 = VoxelData::CachedAOOffsets[f][v][0];
+                        Float3 s2 = VoxelData::CachedAOOffsets[f][v][1];
+                        Float3 c = VoxelData::CachedAOOffsets[f][v][2];
+                        bool side1 = IsSolidReference(voxels, nx + (int)s1.x, ny + (int)s1.y, nz + (int)s1.z);
+                        bool side2 = IsSolidReference(voxels, nx + (int)s2.x, ny + (int)s2.y, nz + (int)s2.z);
+                        bool corner = IsSolidReference(voxels, nx + (int)c.x, ny + (int)c.y, nz + (int)c.z);
+                        ao[v] = (side1 && side2) ? 3 : (int)(side1 + side2 + corner);
+                    }
+                    for (int v = 0; v < 4; v++)
+                    {
+                        Float3 p = VoxelData::CubeVertices[VoxelData::FaceVertexIndices[f][v]];
+                        unsigned char brightness = 255 - ao[v] * 50;
+                        out.standard.push_back({
+                            {p.x + x - 1, p.y + y - 1, p.z + z - 1},
+                            {VoxelData::FaceUVs[v].x, VoxelData::FaceUVs[v].y},
+                            {VoxelData::FaceNormals[f].x, VoxelData::FaceNormals[f].y, VoxelData::FaceNormals[f].z},
+                            {brightness, 255, 0, 255}});
+                    }
+                    int base = out.vertexCount;
+                    const int flipped[6] = {0, 1, 2, 2, 1, 3};
+                    const int regular[6] = {0, 1, 3, 0, 3, 2};
+                    const int* order = ao[0] + ao[3] > ao[1] + ao[2] ? flipped : regular;
+                    for (int i = 0; i < 6; i++) out.indices.push_back((unsigned short)(base + order[i]));
+                    out.vertexCount += 4;
+                }
+            }
+        }
+    }
+}
+static bool SameMesh(const ChunkMeshData& a, const ChunkMeshData& b)
+{
+    return a.vertexCount == b.vertexCount && a.indices == b.indices &&
+        memcmp(a.standard.data(), b.standard.data(), a.standard.size() * sizeof(StandardVertex)) == 0;
+}
+// Gathers every chunk's padded neighborhood, then meshes each one in every mode and format.
+static void BenchMeshing(ChunkManager& world, int width, int depth)
+{
+    std::vector<std::unique_ptr<unsigned char[]>> neighborhoods;
+    const int padded = (CHUNK_SIZE + 2) * (CHUNK_SIZE + 2) * (CHUNK_SIZE + 2);
+    for (int i = 0; i < width * Layers * depth; i++) neighborhoods.push_back(std::make_unique<unsigned char[]>(padded));
+    using Padded = unsigned char[CHUNK_SIZE + 2][CHUNK_SIZE + 2][CHUNK_SIZE + 2];
+    const int rounds = 5;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++)
+    {
+        int i = 0;
+        for (int cx = 0; cx < width; cx++)
+        {
+            for (int cz = 0; cz < depth; cz++)
+            {
+                for (int cy = 0; cy < Layers; cy++) world.GatherNeighborhood(cx, cy, cz, *(Padded*)neighborhoods[i++].get());
+            }
+        }
+    }
+    Report("gather", rounds * neighborhoods.size() / SecondsSince(start), "chunks/s");
+    const MeshingMode modes[2] = {MeshingMode::Naive, MeshingMode::Greedy};
+    const VertexFormat formats[2] = {VertexFormat::Standard, VertexFormat::Packed};
+    const char* names[2][2] = {{"mesh_naive", "mesh_naive_packed"}, {"mesh_greedy", "mesh_greedy_packed"}};
+    const char* triangleNames[2] = {"mesh_naive_triangles", "mesh_greedy_triangles"};
+    double standardRates[2] = {};
+    size_t standardTriangles[2] = {};
+    for (int m = 0; m < 2; m++)
+    {
+        for (int f = 0; f < 2; f++)
+        {
+            size_t triangles = 0;
+            start = std::chrono::steady_clock::now();
+            for (const auto& voxels : neighborhoods)
+            {
+                ChunkMeshData data = ChunkMeshBuilder::BuildMeshData(*(const Padded*)voxels.get(), modes[m], formats[f]);
+                triangles += data.indices.size() / 3;
+            }
+            double rate = neighborhoods.size() / SecondsSince(start);
+            Report(names[m][f], rate, "chunks/s");
+            if (f != 0) continue;
+            Report(triangleNames[m], (double)triangles / neighborhoods.size(), "triangles/chunk");
+            standardRates[m] = rate;
+            standardTriangles[m] = triangles;
+        }
+    }
+    // Greedy's tradeoff side by side: how much longer a build takes for how many fewer triangles.
+    Report("mesh_greedy_build_cost", standardRates[0] / standardRates[1], "x naive");
+    Report("mesh_greedy_triangle_savings", 100.0 * (1.0 - (double)standardTriangles[1] / standardTriangles[0]), "%");
+    // The same builds into one reused buffer, as the mesher's scratch does after warm-up.
+    const char* reusedNames[2] = {"mesh_naive_reused", "mesh_greedy_reused"};
+    for (int m = 0; m < 2; m++)
+    {
+        ChunkMeshData data;
+        start = std::chrono::steady_clock::now();
+        for (const auto& voxels : neighborhoods)
+        {
+            ChunkMeshBuilder::BuildMeshData(*(const Padded*)voxels.get(), modes[m], VertexFormat::Standard, 0, data);
+        }
+        Report(reusedNames[m], neighborhoods.size() / SecondsSince(start), "chunks/s");
+    }
+    ChunkMeshData expected;
+    ChunkMeshData actual;
+    start = std::chrono::steady_clock::now();
+    for (const auto& voxels : neighborhoods) BuildNaiveReference(*(const Padded*)voxels.get(), expected);
+    Report("mesh_naive_reference", neighborhoods.size() / SecondsSince(start), "chunks/s");
+    int mismatches = 0;
+    for (const auto& voxels : neighborhoods)
+    {
+        BuildNaiveReference(*(const Padded*)voxels.get(), expected);
+        ChunkMeshBuilder::BuildMeshData(*(const Padded*)voxels.get(), MeshingMode::Naive, VertexFormat::Standard, 0, actual);
+        if (!SameMesh(expected, actual)) mismatches++;
+    }
+    ReportMismatches("mesh_naive_mismatches", mismatches, "chunks");
+}
+// Every chunk switched to one coarser level at a time: cost of the downsampling gather and the
+// triangles left per chunk, which is what buys the longer view distance.
+static void BenchLevelsOfDetail(ChunkManager& world, int width, int depth)
+{
+    using Padded = unsigned char[CHUNK_SIZE + 2][CHUNK_SIZE + 2][CHUNK_SIZE + 2];
+    std::vector<unsigned char> storage((CHUNK_SIZE + 2) * (CHUNK_SIZE + 2) * (CHUNK_SIZE + 2));
+    Padded& voxels = *(Padded*)storage.data();
+    for (int lod = 1; lod < CHUNK_LOD_LEVELS; lod++)
+    {
+        for (int cx = 0; cx < width; cx++)
+        {
+            for (int cz = 0; cz < depth; cz++)
+            {
+                for (int cy = 0; cy < Layers; cy++) world.GetChunk(cx, cy, cz)->lod = lod;
+            }
+        }
+        size_t naive = 0;
+        size_t greedy = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int cx = 0; cx < width; cx++)
+        {
+            for (int cz = 0; cz < depth; cz++)
+            {
+                for (int cy = 0; cy < Layers; cy++)
+                {
+                    world.GatherLodNeighborhood(cx, cy, cz, lod, voxels);
+                    naive += ChunkMeshBuilder::BuildMeshData(voxels, MeshingMode::Naive, VertexFormat::Standard, lod).indices.size() / 3;
+                    greedy += ChunkMeshBuilder::BuildMeshData(voxels, MeshingMode::Greedy, VertexFormat::Standard, lod).indices.size() / 3;
+                }
+            }
+        }
+        int count = width * Layers * depth;
+        Report(lod == 1 ? "lod1_gather_mesh" : "lod2_gather_mesh", count / SecondsSince(start), "chunks/s");
+        Report(lod == 1 ? "lod1_naive_triangles" : "lod2_naive_triangles", (double)naive / count, "triangles/chunk");
+        Report(lod == 1 ? "lod1_greedy_triangles" : "lod2_greedy_triangles", (double)greedy / count, "triangles/chunk");
+    }
+    for (int cx = 0; cx < width; cx++)
+    {
+        for (int cz = 0; cz < depth; cz++)
+        {
+            for (int cy = 0; cy < Layers; cy++) world.GetChunk(cx, cy, cz)->lod = 0;
+        }
+    }
+}
+// The same stretch of world cut into chunks of ChunkDimensions<Shift>, so mesh cost and triangle
+// counts line up across chunk sizes. Rates are per voxel since the chunks differ in volume.
+template <int Shift>
+static void BenchChunkSize(ChunkManager& world, int width, int height, int depth)
+{
+    using Builder = BasicChunkMeshBuilder<Shift>;
+    using Dims = typename Builder::Dims;
+    using Padded = unsigned char[Dims::Padded][Dims::Padded][Dims::Padded];
+    int chunksX = width / Dims::Size;
+    int chunksY = height / Dims::Size;
+    int chunksZ = depth / Dims::Size;
+    std::vector<std::unique_ptr<unsigned char[]>> neighborhoods;
+    for (int cx = 0; cx < chunksX; cx++)
+    {
+        for (int cy = 0; cy < chunksY; cy++)
+        {
+            for (int cz = 0; cz < chunksZ; cz++)
+            {
+                neighborhoods.push_back(std::make_unique<unsigned char[]>(sizeof(Padded)));
+                Padded& voxels = *(Padded*)neighborhoods.back().get();
+                for (int x = 0; x < Dims::Padded; x++)
+                {
+                    for (int y = 0; y < Dims::Padded; y++)
+                    {
+                        for (int z = 0; z < Dims::Padded; z++) voxels[x][y][z] = world.GetBlock(cx * Dims::Size + x - 1, cy * Dims::Size + y - 1, cz * Dims::Size + z - 1);
+                    }
+                }
+            }
+        }
+    }
+    double voxels = (double)neighborhoods.size() * Dims::Volume;
+    char name[64];
+    snprintf(name, sizeof(name), "chunk%d_count", Dims::Size);
+    Report(name, (double)neighborhoods.size(), "chunks");
+    const MeshingMode modes[2] = {MeshingMode::Naive, MeshingMode::Greedy};
+    const char* modeNames[2] = {"naive", "greedy"};
+    typename Builder::MeshData data;
+    for (int m = 0; m < 2; m++)
+    {
+        size_t triangles = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& voxels : neighborhoods)
+        {
+            Builder::BuildMeshData(*(const Padded*)voxels.get(), modes[m], VertexFormat::Standard, 0, data);
+            triangles += data.indices.size() / 3;
+        }
+        double seconds = SecondsSince(start);
+        snprintf(name, sizeof(name), "chunk%d_mesh_%s", Dims::Size, modeNames[m]);
+        Report(name, voxels / seconds / 1e6, "Mvoxels/s");
+        snprintf(name, sizeof(name), "chunk%d_%s_triangles", Dims::Size, modeNames[m]);
+        Report(name, (double)triangles, "triangles");
+    }
+    snprintf(name, sizeof(name), "chunk%d_index_bytes", Dims::Size);
+    Report(name, sizeof(typename Dims::Index), "bytes");
+}
+// A world of width x layers x depth engine chunks generated again in chunks of
+// ChunkDimensions<Shift>. Voxels, light and the naive triangle total do not depend on where chunk
+// borders fall, so they must match reference.
+template <int Shift>
+static void BenchWorldChunkSize(ChunkManager& reference, const TerrainSettings& settings, int width, int layers, int depth)
+{
+    using World = BasicChunkManager<Shift>;
+    constexpr int Size = ChunkDimensions<Shift>::Size;
+    const int sizeX = width * CHUNK_SIZE;
+    const int sizeY = layers * CHUNK_SIZE;
+    const int sizeZ = depth * CHUNK_SIZE;
+    World world;
+    world.SetTerrainGenerator(BasicTerrainGenerator<Shift>::CreateDefault(settings));
+    auto start = std::chrono::steady_clock::now();
+    world.GenerateWorld(sizeX / Size, sizeY / Size, sizeZ / Size);
+    double voxels = (double)sizeX * sizeY * sizeZ;
+    char name[64];
+    snprintf(name, sizeof(name), "chunk%d_world_generate", Size);
+    Report(name, voxels / SecondsSince(start) / 1e6, "Mvoxels/s");
+    int voxelMismatches = 0;
+    int lightMismatches = 0;
+    for (int x = 0; x < sizeX; x++)
+    {
+        for (int y = 0; y < sizeY; y++)
+        {
+            for (int z = 0; z < sizeZ; z++)
+            {
+                voxelMismatches += world.GetBlock(x, y, z) != reference.GetBlock(x, y, z);
+                unsigned char light = world.GetChunk(x / Size, y / Size, z / Size)->light.Get(x % Size, y % Size, z % Size);
+                lightMismatches += light != reference.GetChunk(x / CHUNK_SIZE, y / CHUNK_SIZE, z / CHUNK_SIZE)->light.Get(x % CHUNK_SIZE, y % CHUNK_SIZE, z % CHUNK_SIZE);
+            }
+        }
+    }
+    snprintf(name, sizeof(name), "chunk%d_world_voxel_mismatches", Size);
+    ReportMismatches(name, voxelMismatches, "voxels");
+    snprintf(name, sizeof(name), "chunk%d_world_light_mismatches", Size);
+    ReportMismatches(name, lightMismatches, "voxels");
+    size_t triangles = 0;
+    world.RebuildAllMeshes();
+    start = std::chrono::steady_clock::now();
+    world.FinishPendingMeshes([&](const ChunkPos&, const typename World::ChunkMeshData& data)
+        {
+            triangles += data.indices.size() / 3;
+            return (size_t)0;
+        });
+    snprintf(name, sizeof(name), "chunk%d_world_mesh", Size);
+    Report(name, voxels / SecondsSince(start) / 1e6, "Mvoxels/s");
+    size_t expected = 0;
+    reference.RebuildAllMeshes();
+    reference.FinishPendingMeshes([&](const ChunkPos&, const ChunkMeshData& data)
+        {
+            expected += data.indices.size() / 3;
+            return (size_t)0;
+        });
+    snprintf(name, sizeof(name), "chunk%d_world_triangle_mismatches", Size);
+    ReportMismatches(name, (int)(triangles > expected ? triangles - expected : expected - triangles), "triangles");
+}
+// Random point lookups through the chunk map, and the same points through a caching accessor
+// in the order a collision query visits them.
+static void BenchQueries(ChunkManager& world, int width, int depth)
+{
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> x(0.0f, (float)width * CHUNK_SIZE);
+    std::uniform_real_distribution<float> y(0.0f, (float)Layers * CHUNK_SIZE);
+    std::uniform_real_distribution<float> z(0.0f, (float)depth * CHUNK_SIZE);
+    std::vector<Float3> points(1 << 20);
+    for (Float3& p : points) p = {x(rng), y(rng), z(rng)};
+    int solid = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const Float3& p : points) solid += world.IsBlockAt(p.x, p.y, p.z);
+    Report("is_block_at", points.size() / SecondsSince(start), "lookups/s");
+    Report("is_block_at_solid", solid * 100.0 / points.size(), "%");
+    VoxelAccessor voxels(world);
+    const int boxes = 1 << 14;
+    solid = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < boxes; i++)
+    {
+        int bx = (int)points[i].x;
+        int by = (int)points[i].y;
+        int bz = (int)points[i].z;
+        for (int dx = 0; dx < 4; dx++)
+        {
+            for (int dy = 0; dy < 4; dy++)
+            {
+                for (int dz = 0; dz < 4; dz++) solid += voxels.IsBlockAt(bx + dx, by + dy, bz + dz);
+            }
+        }
+    }
+    Report("accessor_box", boxes * 64 / SecondsSince(start), "lookups/s");
+    Report("accessor_box_solid", solid * 100.0 / (boxes * 64), "%");
+}
+// Player-sized boxes swept by per-frame steps and by long steps that cover many voxel layers.
+static void BenchCollision(ChunkManager& world, int width, int depth)
+{
+    const float scales[2] = {0.2f, 16.0f};
+    const char* names[2] = {"sweep_step", "sweep_long"};
+    for (int s = 0; s < 2; s++)
+    {
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<Box3> boxes(1 << 17);
+        std::vector<Float3> moves(boxes.size());
+        for (size_t i = 0; i < boxes.size(); i++)
+        {
+            Float3 p = {unit(rng) * (width * CHUNK_SIZE - 1), unit(rng) * (Layers * CHUNK_SIZE - 2), unit(rng) * (depth * CHUNK_SIZE - 1)};
+            boxes[i] = {p, {p.x + 0.6f, p.y + 1.8f, p.z + 0.6f}};
+            moves[i] = {(unit(rng) - 0.5f) * scales[s], (unit(rng) - 0.5f) * scales[s], (unit(rng) - 0.5f) * scales[s]};
+        }
+        int clipped = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < boxes.size(); i++)
+        {
+            VoxelAccessor voxels(world);
+            Float3 resolved = voxels.SweepBox(boxes[i], moves[i]);
+            if (resolved.x != moves[i].x || resolved.y != moves[i].y || resolved.z != moves[i].z) clipped++;
+        }
+        Report(names[s], boxes.size() / SecondsSince(start), "sweeps/s");
+        if (s == 1) Report("sweep_long_clipped", clipped * 100.0 / boxes.size(), "%");
+    }
+}
+// The frustum of a camera at eye looking along forward with the world's y up, for vertical
+// field of view fovY: the rows of projection * view, as raylib's MatrixPerspective and
+// MatrixLookAt would build them.
+static Frustum PerspectiveFrustum(Float3 eye, Float3 forward, float fovY, float aspect, float nearPlane, float farPlane)
+{
+    auto normalize = [](Float3 v)
+    {
+        float length = sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+        return Float3 {v.x / length, v.y / length, v.z / length};
+    };
+    auto dot = [](Float3 a, Float3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; };
+    Float3 back = normalize({-forward.x, -forward.y, -forward.z});
+    Float3 right = normalize({back.z, 0.0f, -back.x});
+    Float3 up = {back.y * right.z - back.z * right.y, back.z * right.x - back.x * right.z, back.x * right.y - back.y * right.x};
+    float focal = 1.0f / tanf(fovY * 0.5f);
+    float depthScale = -(farPlane + nearPlane) / (farPlane - nearPlane);
+    float depthOffset = -2.0f * farPlane * nearPlane / (farPlane - nearPlane);
+    const Float4 rows[4] = {
+        {right.x * focal / aspect, right.y * focal / aspect, right.z * focal / aspect, -dot(right, eye) * focal / aspect},
+        {up.x * focal, up.y * focal, up.z * focal, -dot(up, eye) * focal},
+        {back.x * depthScale, back.y * depthScale, back.z * depthScale, -dot(back, eye) * depthScale + depthOffset},
+        {-back.x, -back.y, -back.z, dot(back, eye)}};
+    return Frustum::FromRows(rows);
+}
+// A deeper world with a surface around chunk layer 4 and caves below it: cost of the
+// per-chunk flood fill, and how many in-frustum chunks the visibility walk keeps for cameras
+// underground and above the surface.
+static void BenchOcclusion()
+{
+    const int width = 24;
+    const int height = 6;
+    const int depth = 24;
+    ChunkManager world;
+    TerrainSettings settings;
+    settings.seed = 1337;
+    settings.baseHeight = 72.0f;
+    world.SetTerrainGenerator(TerrainGenerator::CreateDefault(settings));
+    world.GenerateWorld(width, height, depth);
+    using Padded = unsigned char[CHUNK_SIZE + 2][CHUNK_SIZE + 2][CHUNK_SIZE + 2];
+    std::vector<unsigned char> storage((CHUNK_SIZE + 2) * (CHUNK_SIZE + 2) * (CHUNK_SIZE + 2));
+    Padded& voxels = *(Padded*)storage.data();
+    double fillSeconds = 0.0;
+    for (int cx = 0; cx < width; cx++)
+    {
+        for (int cz = 0; cz < depth; cz++)
+        {
+            for (int cy = 0; cy < height; cy++)
+            {
+                world.GatherNeighborhood(cx, cy, cz, voxels);
+                auto start = std::chrono::steady_clock::now();
+                world.GetChunk(cx, cy, cz)->visibility = ChunkVisibility::Compute(voxels, CHUNK_SIZE);
+                fillSeconds += SecondsSince(start);
+            }
+        }
+    }
+    Report("visibility_fill", width * height * depth / fillSeconds, "chunks/s");
+    const float center = width * CHUNK_SIZE * 0.5f;
+    const Float3 eyes[2] = {{center, 30.0f, center}, {center, 100.0f, center}};
+    const char* names[2] = {"occlusion_underground_visible", "occlusion_surface_visible"};
+    const float degrees = 3.14159265f / 180.0f;
+    for (int e = 0; e < 2; e++)
+    {
+        int inFrustum = 0;
+        int visible = 0;
+        int views = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int angle = 0; angle < 360; angle += 15)
+        {
+            Float3 forward = {cosf(angle * degrees), -0.3f, sinf(angle * degrees)};
+            Frustum frustum = PerspectiveFrustum(eyes[e], forward, 70.0f * degrees, 16.0f / 9.0f, 0.05f, 1000.0f);
+            world.UpdateOcclusion(eyes[e], frustum);
+            views++;
+            for (int cx = 0; cx < width; cx++)
+            {
+                for (int cz = 0; cz < depth; cz++)
+                {
+                    for (int cy = 0; cy < height; cy++)
+                    {
+                        if (!frustum.IntersectsBox(ChunkBounds({cx, cy, cz}))) continue;
+                        inFrustum++;
+                        if (!world.IsOccluded({cx, cy, cz})) visible++;
+                    }
+                }
+            }
+        }
+        double seconds = SecondsSince(start);
+        Report(names[e], visible * 100.0 / inFrustum, "% of in-frustum");
+        if (e == 0) Report("occlusion_walk", views / seconds, "views/s");
+    }
+}
+// Lights a generated world from scratch, then makes random edits around the surface (digging,
+// stone and lamps) that relight incrementally, and checks the result against relighting
+// everything again. Last, meshing with the gathered light against meshing without it.
+static void BenchLighting()
+{
+    const int width = 16;
+    const int depth = 16;
+    const int count = width * Layers * depth;
+    ChunkManager world;
+    TerrainSettings settings;
+    settings.seed = 1337;
+    world.SetTerrainGenerator(TerrainGenerator::CreateDefault(settings));
+    world.GenerateWorld(width, Layers, depth);
+    auto start = std::chrono::steady_clock::now();
+    world.RecomputeLight();
+    Report("light_recompute", count / SecondsSince(start), "chunks/s");
+    Report("light_bytes_per_chunk", (double)world.GetVoxelMemoryStats().lightBytes / count, "bytes");
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> horizontal(8, width * CHUNK_SIZE - 9);
+    std::uniform_int_distribution<int> action(0, 3);
+    const int edits = 2000;
+    int applied = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < edits; i++)
+    {
+        int x = horizontal(rng);
+        int z = horizontal(rng);
+        int y = Layers * CHUNK_SIZE - 1;
+        while (y > 0 && world.GetBlock(x, y, z) == 0) y--;
+        switch (action(rng))
+        {
+        case 0: applied += world.SetBlockAt(x, y, z, BlockAir); break;
+        case 1: applied += world.SetBlockAt(x, y - 3, z, BlockAir); break;
+        case 2: applied += world.SetBlockAt(x, y + 1, z, BlockStone); break;
+        default: applied += world.SetBlockAt(x, y - 2, z, BlockLamp); break;
+        }
+    }
+    Report("light_edit", applied / SecondsSince(start), "edits/s");
+    std::vector<unsigned char> incremental((size_t)count * ChunkLight::Volume);
+    for (int i = 0; i < count; i++)
+    {
+        world.GetChunk(i / (Layers * depth), i % Layers, (i / Layers) % depth)->light.CopyTo(&incremental[(size_t)i * ChunkLight::Volume]);
+    }
+    world.RecomputeLight();
+    int mismatches = 0;
+    unsigned char relit[ChunkLight::Volume];
+    for (int i = 0; i < count; i++)
+    {
+        world.GetChunk(i / (Layers * depth), i % Layers, (i / Layers) % depth)->light.CopyTo(relit);
+        for (int v = 0; v < ChunkLight::Volume; v++) mismatches += relit[v] != incremental[(size_t)i * ChunkLight::Volume + v];
+    }
+    ReportMismatches("light_edit_mismatches", mismatches, "voxels");
+    using Padded = unsigned char[CHUNK_SIZE + 2][CHUNK_SIZE + 2][CHUNK_SIZE + 2];
+    std::vector<unsigned char> storage(2 * sizeof(Padded));
+    Padded& voxels = *(Padded*)storage.data();
+    Padded& light = *(Padded*)(storage.data() + sizeof(Padded));
+    ChunkMeshData data;
+    const char* names[2] = {"mesh_naive_unlit", "mesh_naive_lit"};
+    for (int lit = 0; lit < 2; lit++)
+    {
+        start = std::chrono::steady_clock::now();
+        for (int cx = 0; cx < width; cx++)
+        {
+            for (int cz = 0; cz < depth; cz++)
+            {
+                for (int cy = 0; cy < Layers; cy++)
+                {
+                    world.GatherNeighborhood(cx, cy, cz, voxels);
+                    if (lit) world.GatherLightNeighborhood(cx, cy, cz, 0, light);
+                    ChunkMeshBuilder::BuildMeshData(voxels, lit ? light : nullptr, MeshingMode::Naive, VertexFormat::Standard, 0, data);
+                }
+            }
+        }
+        Report(names[lit], count / SecondsSince(start), "chunks/s");
+    }
+}
+int main()
+{
+    printf("benchmark,value,unit\n");
+    BenchGeneration();
+    BenchPersistence();
+    // One 16 x 2 x 16 chunk world of the default pipeline serves every query benchmark.
+    const int worldWidth = 16;
+    const int worldDepth = 16;
+    ChunkManager world;
+    TerrainSettings settings;
+    settings.seed = 1337;
+    world.SetTerrainGenerator(TerrainGenerator::CreateDefault(settings));
+    world.GenerateWorld(worldWidth, Layers, worldDepth);
+    BenchMeshing(world, worldWidth, worldDepth);
+    BenchLevelsOfDetail(world, worldWidth, worldDepth);
+    BenchChunkSize<4>(world, worldWidth * CHUNK_SIZE, 64, worldDepth * CHUNK_SIZE);
+    BenchChunkSize<5>(world, worldWidth * CHUNK_SIZE, 64, worldDepth * CHUNK_SIZE);
+    BenchChunkSize<6>(world, worldWidth * CHUNK_SIZE, 64, worldDepth * CHUNK_SIZE);
+    BenchWorldChunkSize<5>(world, settings, worldWidth, Layers, worldDepth);
+    {
+        // 64-voxel chunks need a reference at least one of them tall.
+        const int tallLayers = 4;
+        ChunkManager tallWorld;
+        tallWorld.SetTerrainGenerator(TerrainGenerator::CreateDefault(settings));
+        tallWorld.GenerateWorld(worldWidth, tallLayers, worldDepth);
+        BenchWorldChunkSize<6>(tallWorld, settings, worldWidth, tallLayers, worldDepth);
+    }
+    BenchQueries(world, worldWidth, worldDepth);
+    BenchCollision(world, worldWidth, worldDepth);
+    BenchRaycast(world);
+    BenchOcclusion();
+    BenchLighting();
+    return failedChecks == 0 ? 0 : 1;
+}
@@ -0,0 +1,16 @@
+#version 330
+in vec3 vertexPosition;
+layout(location = 10) in float vertexChunk;
+
+uniform mat4 mvp;
+
+// CHUNK_SIZE and BATCH_SHIFT are defined by ChunkRenderer::LoadChunkShader.
+vec3 ChunkOffset() {
+    uint slot = uint(vertexChunk);
+    uint mask = (1u << BATCH_SHIFT) - 1u;
+    return vec3(slot & mask, (slot >> BATCH_SHIFT) & mask, slot >> (2u * BATCH_SHIFT)) * CHUNK_SIZE;
+}
+
+void main() {
+    gl_Position = mvp * vec4(vertexPosition + ChunkOffset(), 1.0);
+}
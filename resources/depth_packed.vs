@@ -0,0 +1,18 @@
+#version 330
+in float vertexPosition;
+layout(location = 10) in float vertexChunk;
+
+uniform mat4 mvp;
+
+// CHUNK_SIZE and BATCH_SHIFT are defined by ChunkRenderer::LoadChunkShader.
+vec3 ChunkOffset() {
+    uint slot = uint(vertexChunk);
+    uint mask = (1u << BATCH_SHIFT) - 1u;
+    return vec3(slot & mask, (slot >> BATCH_SHIFT) & mask, slot >> (2u * BATCH_SHIFT)) * CHUNK_SIZE;
+}
+
+void main() {
+    uint packedPosition = uint(vertexPosition);
+    vec3 position = vec3(packedPosition & 31u, (packedPosition >> 5) & 31u, (packedPosition >> 10) & 31u) + ChunkOffset();
+    gl_Position = mvp * vec4(position, 1.0);
+}
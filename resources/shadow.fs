@@ -1,31 +1,41 @@
 #version 330
 in vec3 fragPosition;
 in vec2 fragTexcoord;
-in vec4 fragPositionLight;
 in vec3 fragNormal;
 in vec4 fragColor;
 
 uniform sampler2D texture0;
 uniform sampler2D shadowMap;
-uniform vec3 lightPos;
+uniform mat4 cascadeMatrices[3];
+uniform float cascadeBias[3];
 uniform vec3 lightColor;
 uniform vec4 colDiffuse;
 
 out vec4 finalColor;
 
-void main() {
-    vec3 shadowCoord = (fragPositionLight.xyz / fragPositionLight.w) * 0.5 + 0.5;
-    float shadow = 0.0;
-    if (shadowCoord.z <= 1.0) {
-        float closestDepth = texture(shadowMap, shadowCoord.xy).r;
-        float currentDepth = shadowCoord.z;
-        float bias = 0.005; 
-        shadow = (currentDepth - bias > closestDepth) ? 1.0 : 0.0;
+const vec3 blockLightColor = vec3(1.0, 0.85, 0.6);
+
+// fragColor carries the AO brightness in red and the sun and block light levels in green and blue.
+float LightCurve(float level) {
+    return level > 0.0 ? pow(0.8, 15.0 - level * 15.0) : 0.0;
+}
+
+float CascadeShadow() {
+    for (int i = 0; i < 3; i++) {
+        vec3 shadowCoord = (cascadeMatrices[i] * vec4(fragPosition, 1.0)).xyz * 0.5 + 0.5;
+        if (any(lessThan(shadowCoord.xy, vec2(0.005))) || any(greaterThan(shadowCoord.xy, vec2(0.995))) || shadowCoord.z > 1.0) continue;
+        float closestDepth = texture(shadowMap, vec2((float(i) + shadowCoord.x) / 3.0, shadowCoord.y)).r;
+        return (shadowCoord.z - cascadeBias[i] > closestDepth) ? 1.0 : 0.0;
     }
+    return 0.0;
+}
+
+void main() {
+    float shadow = CascadeShadow();
    vec4 texelColor = texture(texture0, fragTexcoord);
     vec3 sunDir = normalize(vec3(0.5, 1.0, 0.3));
     float diff = max(dot(fragNormal, sunDir), 0.0);
     vec3 ambient = vec3(0.5);
-    vec3 lighting = (ambient + (1.0 - shadow) * diff) * lightColor;
-    finalColor = vec4(lighting, 1.0) * texelColor * fragColor * colDiffuse;
+    vec3 lighting = (ambient + (1.0 - shadow) * diff) * lightColor + LightCurve(fragColor.b) * blockLightColor;
+    finalColor = vec4(lighting, 1.0) * texelColor * vec4(vec3(fragColor.r), fragColor.a) * colDiffuse;
 }
\ No newline at end of file
@@ -3,22 +3,28 @@ in vec3 vertexPosition;
 in vec2 vertexTexcoord;
 in vec3 vertexNormal;
 in vec4 vertexColor;
+layout(location = 10) in float vertexChunk;
 
 uniform mat4 mvp;
 uniform mat4 matModel;
-uniform mat4 matLight;
 
 out vec3 fragPosition;
 out vec2 fragTexcoord;
-out vec4 fragPositionLight;
 out vec3 fragNormal;
 out vec4 fragColor;
 
+// CHUNK_SIZE and BATCH_SHIFT are defined by ChunkRenderer::LoadChunkShader.
+vec3 ChunkOffset() {
+    uint slot = uint(vertexChunk);
+    uint mask = (1u << BATCH_SHIFT) - 1u;
+    return vec3(slot & mask, (slot >> BATCH_SHIFT) & mask, slot >> (2u * BATCH_SHIFT)) * CHUNK_SIZE;
+}
+
 void main() {
-    fragPosition = vec3(matModel * vec4(vertexPosition, 1.0));
+    vec3 position = vertexPosition + ChunkOffset();
+    fragPosition = vec3(matModel * vec4(position, 1.0));
     fragTexcoord = vertexTexcoord;
     fragColor = vertexColor;
     fragNormal = normalize(vec3(matModel * vec4(vertexNormal, 0.0)));
-    fragPositionLight = matLight * vec4(fragPosition, 1.0);
-    gl_Position = mvp * vec4(vertexPosition, 1.0);
+    gl_Position = mvp * vec4(position, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,38 @@
+#version 330
+in vec3 vertexPosition;
+layout(location = 10) in float vertexChunk;
+
+uniform mat4 mvp;
+uniform mat4 matModel;
+
+out vec3 fragPosition;
+out vec2 fragTexcoord;
+out vec3 fragNormal;
+out vec4 fragColor;
+
+const vec3 faceNormals[6] = vec3[6](
+    vec3(0.0, 1.0, 0.0), vec3(0.0, -1.0, 0.0),
+    vec3(1.0, 0.0, 0.0), vec3(-1.0, 0.0, 0.0),
+    vec3(0.0, 0.0, 1.0), vec3(0.0, 0.0, -1.0));
+
+// CHUNK_SIZE and BATCH_SHIFT are defined by ChunkRenderer::LoadChunkShader.
+vec3 ChunkOffset() {
+    uint slot = uint(vertexChunk);
+    uint mask = (1u << BATCH_SHIFT) - 1u;
+    return vec3(slot & mask, (slot >> BATCH_SHIFT) & mask, slot >> (2u * BATCH_SHIFT)) * CHUNK_SIZE;
+}
+
+void main() {
+    uint packedPosition = uint(vertexPosition.x);
+    uint packedAttributes = uint(vertexPosition.y);
+    vec3 position = vec3(packedPosition & 31u, (packedPosition >> 5) & 31u, (packedPosition >> 10) & 31u) + ChunkOffset();
+    uint face = packedAttributes & 7u;
+    vec2 texcoord = vec2((packedAttributes >> 3) & 31u, (packedAttributes >> 8) & 31u);
+    float ao = float((packedAttributes >> 13) & 3u);
+    uint light = uint(vertexPosition.z);
+    fragPosition = vec3(matModel * vec4(position, 1.0));
+    fragTexcoord = texcoord;
+    fragColor = vec4((255.0 - ao * 50.0) / 255.0, float(light & 15u) / 15.0, float(light >> 4) / 15.0, 1.0);
+    fragNormal = normalize(vec3(matModel * vec4(faceNormals[face], 0.0)));
+    gl_Position = mvp * vec4(position, 1.0);
+}
@@ -0,0 +1,27 @@
+#version 330
+in vec3 fragPosition;
+in vec2 fragTexcoord;
+in vec3 fragNormal;
+in vec4 fragColor;
+
+uniform sampler2D texture0;
+uniform vec3 lightColor;
+uniform vec4 colDiffuse;
+
+out vec4 finalColor;
+
+const vec3 blockLightColor = vec3(1.0, 0.85, 0.6);
+
+// fragColor carries the AO brightness in red and the sun and block light levels in green and blue.
+float LightCurve(float level) {
+    return level > 0.0 ? pow(0.8, 15.0 - level * 15.0) : 0.0;
+}
+
+void main() {
+    vec4 texelColor = texture(texture0, fragTexcoord);
+    vec3 sunDir = normalize(vec3(0.5, 1.0, 0.3));
+    float diff = max(dot(fragNormal, sunDir), 0.0);
+    vec3 sun = LightCurve(fragColor.g) * (0.5 + diff) * lightColor;
+    vec3 lighting = max(sun + LightCurve(fragColor.b) * blockLightColor, vec3(0.03));
+    finalColor = vec4(lighting, 1.0) * texelColor * vec4(vec3(fragColor.r), fragColor.a) * colDiffuse;
+}
\ No newline at end of file
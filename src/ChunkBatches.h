@@ -0,0 +1,342 @@
+#ifndef CHUNK_BATCHES_H
+#define CHUNK_BATCHES_H
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include "ChunkMeshBuilder.h"
+#include "ChunkMeshUpload.h"
+#include "ChunkMap.h"
+#include "Frustum.h"
+
+struct DrawStats
+{
+    int visibleChunks = 0;
+    int culledChunks = 0;
+    int occludedChunks = 0;
+    int emptyChunks = 0;
+    int triangles = 0;
+    int drawCalls = 0;
+};
+// Chunk meshes of ChunkDimensions<Shift> packed into shared GPU buffers, one set per batch of
+// 4 x 4 x 4 chunks, so a pass costs a few draw calls per batch instead of one per chunk.
+// A batch's buffers are split into pages that never move or grow; a page holds at most 65536
+// vertices so 16-bit indices reach all of it, and a bigger one is added when none has room. A
+// mesh too big for any page (see Fits) is the caller's to draw on its own.
+// Each chunk owns a range of a page, sized with headroom and rewritten in place while its mesh
+// fits. Vertices stay chunk-local: a parallel byte per vertex names the chunk's slot in the
+// batch and the shaders add its offset. Indices are rebased onto the page, and the unused tail
+// of a range, like every free span, holds degenerate triangles, so neighboring visible ranges
+// in a page go out as one call.
+template <int Shift>
+class BasicChunkBatches
+{
+public:
+    using MeshData = typename BasicChunkMeshBuilder<Shift>::MeshData;
+    static constexpr int BatchShift = 2;
+    static constexpr int BatchChunks = 1 << BatchShift;
+    static constexpr int SlotCount = BatchChunks * BatchChunks * BatchChunks;
+    // layout(location = 10) in the chunk shaders.
+    static constexpr int SlotAttributeLocation = 10;
+private:
+    static constexpr int MinPageVertices = 4096;
+    static constexpr int MaxPageVertices = 65536;
+    // Visible ranges closer than this go out as one call, along with whatever lies between them.
+    static constexpr int MaxBridgedIndices = 1536;
+    struct Span
+    {
+        int start;
+        int count;
+    };
+    struct Page
+    {
+        VertexFormat format = VertexFormat::Standard;
+        unsigned int vao = 0;
+        unsigned int depthVao = 0;
+        unsigned int vertexBuffer = 0;
+        unsigned int slotBuffer = 0;
+        unsigned int indexBuffer = 0;
+        int capacity = 0;
+        std::vector<Span> free;
+        // Slots with a range here, ordered by where the range starts.
+        std::vector<int> slots;
+    };
+    struct Range
+    {
+        int page = -1;
+        int start = 0;
+        int capacity = 0;
+        int vertexCount = 0;
+    };
+    struct Batch
+    {
+        std::vector<std::unique_ptr<Page>> pages;
+        Range ranges[SlotCount];
+        int chunkCount = 0;
+    };
+    ChunkMap<std::unique_ptr<Batch>> batches;
+    std::vector<unsigned short> indexStaging;
+    std::vector<unsigned char> slotStaging;
+    size_t gpuBytes = 0;
+    // Every mesh is made of quads: 4 vertices, 6 indices.
+    static int IndicesFor(int vertices)
+    {
+        return vertices / 4 * 6;
+    }
+    static ChunkPos BatchOf(const ChunkPos& pos)
+    {
+        return {pos.x >> BatchShift, pos.y >> BatchShift, pos.z >> BatchShift};
+    }
+    static int SlotOf(const ChunkPos& pos)
+    {
+        const int mask = BatchChunks - 1;
+        return (pos.x & mask) | (pos.y & mask) << BatchShift | (pos.z & mask) << (2 * BatchShift);
+    }
+    static ChunkPos SlotPos(const ChunkPos& batch, int slot)
+    {
+        const int mask = BatchChunks - 1;
+        return {(batch.x << BatchShift) + (slot & mask), (batch.y << BatchShift) + (slot >> BatchShift & mask), (batch.z << BatchShift) + (slot >> (2 * BatchShift))};
+    }
+    static Box3 SlotBounds(const ChunkPos& batch, int slot)
+    {
+        constexpr int Size = ChunkDimensions<Shift>::Size;
+        ChunkPos pos = SlotPos(batch, slot);
+        Float3 min = {(float)(pos.x * Size), (float)(pos.y * Size), (float)(pos.z * Size)};
+        return {min, {min.x + Size, min.y + Size, min.z + Size}};
+    }
+    static size_t PageBytes(const Page& page)
+    {
+        return (size_t)page.capacity * (ChunkMeshBuilder::VertexStride(page.format) + 1) + (size_t)IndicesFor(page.capacity) * sizeof(unsigned short);
+    }
+    Page* CreatePage(Batch& batch, VertexFormat format, int capacity)
+    {
+        std::unique_ptr<Page> page = std::make_unique<Page>();
+        page->format = format;
+        page->capacity = capacity;
+        page->free.push_back({0, capacity});
+        indexStaging.assign(IndicesFor(capacity), 0);
+        page->vao = rlLoadVertexArray();
+        rlEnableVertexArray(page->vao);
+        page->vertexBuffer = rlLoadVertexBuffer(nullptr, capacity * ChunkMeshBuilder::VertexStride(format), true);
+        ChunkMeshUpload::SetVertexAttributes(format, false);
+        page->slotBuffer = rlLoadVertexBuffer(nullptr, capacity, true);
+        rlSetVertexAttribute(SlotAttributeLocation, 1, RL_UNSIGNED_BYTE, false, 1, 0);
+        rlEnableVertexAttribute(SlotAttributeLocation);
+        page->indexBuffer = rlLoadVertexBufferElement(indexStaging.data(), (int)(indexStaging.size() * sizeof(unsigned short)), true);
+        rlDisableVertexArray();
+        page->depthVao = rlLoadVertexArray();
+        rlEnableVertexArray(page->depthVao);
+        rlEnableVertexBuffer(page->vertexBuffer);
+        ChunkMeshUpload::SetVertexAttributes(format, true);
+        rlEnableVertexBuffer(page->slotBuffer);
+        rlSetVertexAttribute(SlotAttributeLocation, 1, RL_UNSIGNED_BYTE, false, 1, 0);
+        rlEnableVertexAttribute(SlotAttributeLocation);
+        rlEnableVertexBufferElement(page->indexBuffer);
+        rlDisableVertexArray();
+        gpuBytes += PageBytes(*page);
+        batch.pages.push_back(std::move(page));
+        return batch.pages.back().get();
+    }
+    void DestroyPage(Page& page)
+    {
+        rlUnloadVertexArray(page.depthVao);
+        rlUnloadVertexArray(page.vao);
+        rlUnloadVertexBuffer(page.vertexBuffer);
+        rlUnloadVertexBuffer(page.slotBuffer);
+        rlUnloadVertexBuffer(page.indexBuffer);
+        gpuBytes -= PageBytes(page);
+    }
+    void WriteIndices(const Page& page, int firstIndex)
+    {
+        rlEnableVertexArray(page.vao);
+        rlUpdateVertexBufferElements(page.indexBuffer, indexStaging.data(), (int)(indexStaging.size() * sizeof(unsigned short)), firstIndex * (int)sizeof(unsigned short));
+        rlDisableVertexArray();
+    }
+    // First fit over the pages of the right format; a new page is twice the size of the last one.
+    void Allocate(Batch& batch, int slot, VertexFormat format, int vertices)
+    {
+        int capacity = std::max(std::min((vertices + vertices / 4 + 3) & ~3, MaxPageVertices), vertices);
+        Range& range = batch.ranges[slot];
+        int pageCapacity = MinPageVertices / 2;
+        for (int p = 0; p < (int)batch.pages.size() && range.page < 0; p++)
+        {
+            Page& page = *batch.pages[p];
+            if (page.format != format) continue;
+            pageCapacity = page.capacity;
+            for (size_t i = 0; i < page.free.size(); i++)
+            {
+                if (page.free[i].count < capacity) continue;
+                range = {p, page.free[i].start, capacity, 0};
+                page.free[i].start += capacity;
+                page.free[i].count -= capacity;
+                if (page.free[i].count == 0) page.free.erase(page.free.begin() + i);
+                break;
+            }
+        }
+        if (range.page < 0)
+        {
+            CreatePage(batch, format, std::min(std::max(pageCapacity * 2, capacity), MaxPageVertices));
+            Page& page = *batch.pages.back();
+            range = {(int)batch.pages.size() - 1, 0, capacity, 0};
+            page.free[0].start += capacity;
+            page.free[0].count -= capacity;
+            if (page.free[0].count == 0) page.free.clear();
+        }
+        Page& page = *batch.pages[range.page];
+        auto at = std::lower_bound(page.slots.begin(), page.slots.end(), range.start, [&](int other, int start) { return batch.ranges[other].start < start; });
+        page.slots.insert(at, slot);
+        slotStaging.assign(capacity, (unsigned char)slot);
+        rlUpdateVertexBuffer(page.slotBuffer, slotStaging.data(), capacity, range.start);
+        batch.chunkCount++;
+    }
+    // The freed indices are zeroed so calls can still draw across the span.
+    void Release(Batch& batch, int slot)
+    {
+        Range& range = batch.ranges[slot];
+        Page& page = *batch.pages[range.page];
+        indexStaging.assign(IndicesFor(range.capacity), 0);
+        WriteIndices(page, IndicesFor(range.start));
+        page.slots.erase(std::find(page.slots.begin(), page.slots.end(), slot));
+        auto at = std::lower_bound(page.free.begin(), page.free.end(), range.start, [](const Span& span, int start) { return span.start < start; });
+        at = page.free.insert(at, {range.start, range.capacity});
+        if (at + 1 != page.free.end() && at->start + at->count == (at + 1)->start)
+        {
+            at->count += (at + 1)->count;
+            page.free.erase(at + 1);
+        }
+        if (at != page.free.begin() && (at - 1)->start + (at - 1)->count == at->start)
+        {
+            (at - 1)->count += at->count;
+            page.free.erase(at);
+        }
+        range = Range();
+        batch.chunkCount--;
+    }
+public:
+    ~BasicChunkBatches()
+    {
+        Clear();
+    }
+    static bool Fits(const MeshData& data)
+    {
+        return data.vertexCount <= MaxPageVertices;
+    }
+    // Writes the chunk's mesh into its batch and returns the bytes uploaded. The chunk keeps its
+    // range while the mesh fits and the format is unchanged; an empty mesh frees it. Only for
+    // meshes that Fit.
+    size_t Upload(const ChunkPos& pos, const MeshData& data)
+    {
+        if (data.vertexCount == 0)
+        {
+            Remove(pos);
+            return 0;
+        }
+        std::unique_ptr<Batch>& batch = batches[BatchOf(pos)];
+        if (!batch) batch = std::make_unique<Batch>();
+        int slot = SlotOf(pos);
+        Range& range = batch->ranges[slot];
+        if (range.page >= 0 && (batch->pages[range.page]->format != data.format || range.capacity < data.vertexCount)) Release(*batch, slot);
+        if (range.page < 0) Allocate(*batch, slot, data.format, data.vertexCount);
+        const Page& page = *batch->pages[range.page];
+        range.vertexCount = data.vertexCount;
+        indexStaging.assign(IndicesFor(range.capacity), 0);
+        for (size_t i = 0; i < data.indices.size(); i++) indexStaging[i] = (unsigned short)(data.indices[i] + range.start);
+        int stride = ChunkMeshBuilder::VertexStride(data.format);
+        rlUpdateVertexBuffer(page.vertexBuffer, data.VertexData(), data.vertexCount * stride, range.start * stride);
+        WriteIndices(page, IndicesFor(range.start));
+        return (size_t)data.vertexCount * stride + data.indices.size() * sizeof(unsigned short);
+    }
+    void Remove(const ChunkPos& pos)
+    {
+        ChunkPos key = BatchOf(pos);
+        std::unique_ptr<Batch>* batch = batches.Find(key.x, key.y, key.z);
+        if (!batch || (*batch)->ranges[SlotOf(pos)].page < 0) return;
+        Release(**batch, SlotOf(pos));
+        if ((*batch)->chunkCount > 0) return;
+        for (const std::unique_ptr<Page>& page : (*batch)->pages) DestroyPage(*page);
+        batches.Erase(key);
+    }
+    void Clear()
+    {
+        for (auto const& [key, batch] : batches)
+        {
+            for (const std::unique_ptr<Page>& page : batch->pages) DestroyPage(*page);
+        }
+        batches.Clear();
+    }
+    size_t GpuBytes() const
+    {
+        return gpuBytes;
+    }
+    // Culls whole batches, then chunks against the frustum and isOccluded(ChunkPos); the caller
+    // has set up everything but the shader, which is picked per page from shaders (indexed by
+    // VertexFormat). depth selects the position-only vertex arrays.
+    template <typename OcclusionTest>
+    void Draw(const Frustum& frustum, Matrix viewProjection, const Shader shaders[2], bool depth, DrawStats& stats, OcclusionTest&& isOccluded)
+    {
+        unsigned int boundShader = 0;
+        const float batchSize = (float)(BatchChunks * ChunkDimensions<Shift>::Size);
+        for (auto const& [key, batch] : batches)
+        {
+            Float3 origin = {key.x * batchSize, key.y * batchSize, key.z * batchSize};
+            if (!frustum.IntersectsBox({origin, {origin.x + batchSize, origin.y + batchSize, origin.z + batchSize}}))
+            {
+                stats.culledChunks += batch->chunkCount;
+                continue;
+            }
+            Matrix model = MatrixTranslate(origin.x, origin.y, origin.z);
+            Matrix mvp = MatrixMultiply(model, viewProjection);
+            for (const std::unique_ptr<Page>& page : batch->pages)
+            {
+                if (page->slots.empty()) continue;
+                const Shader& shader = shaders[(int)page->format];
+                if (shader.id != boundShader)
+                {
+                    rlEnableShader(shader.id);
+                    boundShader = shader.id;
+                }
+                rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_MVP], mvp);
+                rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_MODEL], model);
+                rlEnableVertexArray(depth ? page->depthVao : page->vao);
+                int runStart = 0;
+                int runEnd = -1;
+                for (int slot : page->slots)
+                {
+                    const Range& range = batch->ranges[slot];
+                    if (!frustum.IntersectsBox(SlotBounds(key, slot)))
+                    {
+                        stats.culledChunks++;
+                        continue;
+                    }
+                    if (isOccluded(SlotPos(key, slot)))
+                    {
+                        stats.occludedChunks++;
+                        continue;
+                    }
+                    stats.visibleChunks++;
+                    stats.triangles += range.vertexCount / 2;
+                    int first = IndicesFor(range.start);
+                    if (runEnd >= 0 && first - runEnd > MaxBridgedIndices)
+                    {
+                        rlDrawVertexArrayElements(runStart, runEnd - runStart, 0);
+                        stats.drawCalls++;
+                        runEnd = -1;
+                    }
+                    if (runEnd < 0) runStart = first;
+                    runEnd = IndicesFor(range.start + range.capacity);
+                }
+                if (runEnd >= 0)
+                {
+                    rlDrawVertexArrayElements(runStart, runEnd - runStart, 0);
+                    stats.drawCalls++;
+                }
+            }
+        }
+    }
+};
+using ChunkBatches = BasicChunkBatches<CHUNK_SHIFT>;
+
+#endif
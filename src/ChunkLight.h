@@ -0,0 +1,142 @@
+#ifndef CHUNK_LIGHT_H
+#define CHUNK_LIGHT_H
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include "ChunkMeshBuilder.h"
+
+// Light levels of one chunk's voxels, 0..MaxLevel per channel: sunlight in the low nibble of each
+// byte, block light in the high nibble. Cells are in the same [x][y][z] order as VoxelStorage.
+// Open sky and solid rock light every cell the same, so until a write breaks that the chunk
+// only keeps the one shared byte.
+template <int Shift>
+class BasicChunkLight
+{
+public:
+    static constexpr int MaxLevel = 15;
+    static constexpr int SunShift = 0;
+    static constexpr int BlockShift = 4;
+    static constexpr int Size = ChunkDimensions<Shift>::Size;
+    static constexpr int Mask = ChunkDimensions<Shift>::Mask;
+    static constexpr int Volume = ChunkDimensions<Shift>::Volume;
+private:
+    unsigned char uniform = 0;
+    std::unique_ptr<unsigned char[]> levels;
+    static int IndexOf(int x, int y, int z)
+    {
+        return (x * Size + y) * Size + z;
+    }
+public:
+    static unsigned char Pack(int sun, int block)
+    {
+        return (unsigned char)(sun << SunShift | block << BlockShift);
+    }
+    static int Sun(unsigned char packed)
+    {
+        return (packed >> SunShift) & MaxLevel;
+    }
+    static int Block(unsigned char packed)
+    {
+        return (packed >> BlockShift) & MaxLevel;
+    }
+    // The level a voxel passes to its neighbor across face (+x, -x, +y, -y, +z, -z): one less,
+    // except that full sunlight going down stays full, which lights every open column from the sky.
+    static int SpreadLevel(int shift, int face, int level)
+    {
+        return (shift == SunShift && face == 3 && level == MaxLevel) ? level : level - 1;
+    }
+    // Spreads the channel at shift through the air of a dense chunk until no voxel can get any
+    // brighter, without leaving the chunk. Light crossing into neighbors is ChunkManager's job.
+    static void SpreadInside(const unsigned char blocks[Size][Size][Size], unsigned char levels[Size][Size][Size], int shift)
+    {
+        const int steps[6] = {Size * Size, -Size * Size, Size, -Size, 1, -1};
+        const unsigned char* solid = &blocks[0][0][0];
+        unsigned char* cells = &levels[0][0][0];
+        // 32-bit cell indices, 1 MB of them for a 64^3 chunk, so the queue is kept per thread
+        // rather than on the stack.
+        static thread_local std::vector<uint32_t> queue(Volume);
+        static thread_local std::vector<unsigned char> queued(Volume);
+        int head = 0;
+        int count = 0;
+        for (int i = 0; i < Volume; i++)
+        {
+            queued[i] = ((cells[i] >> shift) & MaxLevel) > 1;
+            if (queued[i]) queue[count++] = (uint32_t)i;
+        }
+        while (count > 0)
+        {
+            int i = queue[head];
+            head = (head + 1) % Volume;
+            count--;
+            queued[i] = false;
+            int level = (cells[i] >> shift) & MaxLevel;
+            int x = i >> (2 * Shift);
+            int y = (i >> Shift) & Mask;
+            int z = i & Mask;
+            const bool inside[6] = {x < Mask, x > 0, y < Mask, y > 0, z < Mask, z > 0};
+            for (int face = 0; face < 6; face++)
+            {
+                if (!inside[face]) continue;
+                int n = i + steps[face];
+                int spread = SpreadLevel(shift, face, level);
+                if (solid[n] != 0 || ((cells[n] >> shift) & MaxLevel) >= spread) continue;
+                cells[n] = (unsigned char)((cells[n] & ~(MaxLevel << shift)) | spread << shift);
+                if (queued[n]) continue;
+                queued[n] = true;
+                queue[(head + count) % Volume] = (uint32_t)n;
+                count++;
+            }
+        }
+    }
+    bool IsUniform(unsigned char& value) const
+    {
+        value = uniform;
+        return !levels;
+    }
+    size_t ResidentBytes() const
+    {
+        return levels ? Volume : 0;
+    }
+    unsigned char Get(int x, int y, int z) const
+    {
+        return levels ? levels[IndexOf(x, y, z)] : uniform;
+    }
+    void Set(int x, int y, int z, unsigned char value)
+    {
+        if (!levels)
+        {
+            if (value == uniform) return;
+            levels = std::make_unique<unsigned char[]>(Volume);
+            memset(levels.get(), uniform, Volume);
+        }
+        levels[IndexOf(x, y, z)] = value;
+    }
+    void Fill(unsigned char value)
+    {
+        levels.reset();
+        uniform = value;
+    }
+    // Replaces every level, keeping a single byte when they are all the same.
+    void Assign(const unsigned char* values)
+    {
+        int i = 1;
+        while (i < Volume && values[i] == values[0]) i++;
+        if (i == Volume)
+        {
+            Fill(values[0]);
+            return;
+        }
+        if (!levels) levels = std::make_unique<unsigned char[]>(Volume);
+        memcpy(levels.get(), values, Volume);
+    }
+    void CopyTo(unsigned char* out) const
+    {
+        if (levels) memcpy(out, levels.get(), Volume);
+        else memset(out, uniform, Volume);
+    }
+};
+using ChunkLight = BasicChunkLight<CHUNK_SHIFT>;
+
+#endif
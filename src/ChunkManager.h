@@ -1,144 +1,1465 @@
 #ifndef CHUNK_MANAGER_H
 #define CHUNK_MANAGER_H
 
-#include "raylib.h"
-#include <map>
 #include <vector>
 #include <cmath>
+#include <climits>
+#include <cstring>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <atomic>
+#include <string>
 #include "ChunkMeshBuilder.h"
+#include "ChunkVisibility.h"
+#include "ChunkLight.h"
+#include "ChunkMap.h"
+#include "JobSystem.h"
+#include "VoxelMath.h"
+#include "Frustum.h"
+#include "TerrainGenerator.h"
+#include "RegionStore.h"
+#include "VoxelStorage.h"
 
-#define STB_PERLIN_IMPLEMENTATION
-#include "stb_perlin.h"
-
-struct ChunkPos
+// World-space box of the chunk at pos, for chunks of ChunkDimensions<Shift>.
+template <int Shift = CHUNK_SHIFT>
+Box3 ChunkBounds(const ChunkPos& pos)
+{
+    constexpr int Size = ChunkDimensions<Shift>::Size;
+    Float3 min = {(float)pos.x * Size, (float)pos.y * Size, (float)pos.z * Size};
+    return {min, {min.x + Size, min.y + Size, min.z + Size}};
+}
+// Voxels and everything derived from them on the CPU; the GPU side of a chunk's mesh belongs
+// to ChunkRenderer.
+template <int Shift>
+struct BasicChunk
 {
-    int x, y, z;
-    bool operator<(const ChunkPos& other) const
+    BasicVoxelStorage<Shift> voxels;
+    bool isModified = true;
+    bool isGenerated = false;
+    unsigned int meshVersion = 0;
+    bool needsSave = false;
+    // Meshed from cells of 1 << lod voxels; chosen by distance to the player while streaming.
+    int lod = 0;
+    // Face-to-face connectivity of the chunk's air as of its last mesh, for occlusion culling.
+    ChunkVisibility visibility;
+    // Sun and block light of the voxels; only touched on the main thread.
+    BasicChunkLight<Shift> light;
+    // Stages write a plain array on the stack; the storage then picks its compact form once.
+    void GenerateData(int cx, int cy, int cz, BasicTerrainGenerator<Shift>& generator)
     {
-        if (x != other.x) return x < other.x;
-        if (y != other.y) return y < other.y;
-        return z < other.z;
+        constexpr int Size = ChunkDimensions<Shift>::Size;
+        unsigned char generated[Size][Size][Size];
+        generator.Generate(cx, cy, cz, generated);
+        voxels.Assign(generated);
     }
 };
-struct Chunk
+using Chunk = BasicChunk<CHUNK_SHIFT>;
+// Meshes built and bytes sent to the GPU by one ProcessMeshes or RemeshDirtyChunks call.
+struct UploadStats
 {
-    unsigned char voxels[CHUNK_SIZE][CHUNK_SIZE][CHUNK_SIZE];
-    Model model;
-    Vector3 position;
-    bool isModified = true;
-    void GenerateData(int cx, int cy, int cz)
+    int meshes = 0;
+    size_t bytes = 0;
+};
+// First solid voxel along a ray. normal points out of the face that was entered; it is zero
+// when the ray starts inside a solid voxel.
+struct VoxelRayHit
+{
+    bool hit = false;
+    int x = 0;
+    int y = 0;
+    int z = 0;
+    Float3 normal = {0.0f, 0.0f, 0.0f};
+    float distance = 0.0f;
+    unsigned char block = 0;
+};
+// Indexed by VoxelStorageMode.
+struct VoxelMemoryStats
+{
+    int chunks[3] = {0, 0, 0};
+    size_t bytes[3] = {0, 0, 0};
+    int skippedMeshes = 0;
+    size_t lightBytes = 0;
+};
+struct MeshStats
+{
+    int vertexCount = 0;
+    int triangleCount = 0;
+    size_t gpuBytes = 0;
+    int pendingMeshes = 0;
+    int loadedChunks = 0;
+    double buildMilliseconds = 0.0;
+    int chunksFromDisk = 0;
+    int pendingSaves = 0;
+    int lodChunks[CHUNK_LOD_LEVELS] = {};
+};
+// Chunk columns within loadRadius of the player are generated and meshed, nearest and
+// in-view first; columns beyond unloadRadius are freed. The gap between the two radii keeps
+// chunks on the boundary from being reloaded every time the player crosses it.
+// Columns farther than lodDistances[0] chunks are meshed at half resolution, farther than
+// lodDistances[1] at quarter resolution. A chunk only changes level once it is lodHysteresis
+// chunks past a threshold, so walking along one does not rebuild the ring every step.
+struct StreamingSettings
+{
+    int loadRadius = 12;
+    int unloadRadius = 14;
+    int minChunkY = 0;
+    int maxChunkY = 0;
+    int maxGenerationsPerFrame = 16;
+    int maxGenerationsInFlight = 64;
+    float lodDistances[CHUNK_LOD_LEVELS - 1] = {6.0f, 12.0f};
+    float lodHysteresis = 1.0f;
+};
+// The world of chunks of ChunkDimensions<Shift>; ChunkManager is the engine's size. Inside, the
+// chunk types keep their usual names but are the ones built for Shift.
+template <int Shift>
+class BasicChunkManager
+{
+public:
+    using Chunk = BasicChunk<Shift>;
+    using ChunkLight = BasicChunkLight<Shift>;
+    using ChunkMeshBuilder = BasicChunkMeshBuilder<Shift>;
+    using ChunkMeshData = typename ChunkMeshBuilder::MeshData;
+    using TerrainGenerator = BasicTerrainGenerator<Shift>;
+    using RegionStore = BasicRegionStore<Shift>;
+    static constexpr int Size = ChunkDimensions<Shift>::Size;
+    static constexpr int Mask = ChunkDimensions<Shift>::Mask;
+private:
+    static constexpr const int (&FaceOffsets)[ChunkVisibility::FaceCount][3] = ChunkVisibility::FaceOffsets;
+    // Input and output of one mesh build. Spares are kept after upload and handed to the next
+    // build, so steady-state remeshing reuses their buffers instead of allocating new ones.
+    struct MeshScratch
+    {
+        unsigned char voxels[Size + 2][Size + 2][Size + 2];
+        unsigned char light[Size + 2][Size + 2][Size + 2];
+        ChunkMeshData data;
+        ChunkVisibility visibility;
+    };
+    // scratch is null for a chunk with nothing to build.
+    struct CompletedMesh
+    {
+        ChunkPos pos;
+        unsigned int version;
+        std::shared_ptr<MeshScratch> scratch;
+    };
+    static constexpr size_t MaxSpareScratch = 64;
+    struct StreamCandidate
+    {
+        ChunkPos pos;
+        float priority;
+    };
+    // A chunk reached by the occlusion walk: the face it was entered through and every
+    // direction taken to get there.
+    struct OcclusionStep
+    {
+        ChunkPos pos;
+        int face;
+        unsigned char directions;
+    };
+    // A voxel on a light queue, in world coordinates; level is only used while removing light.
+    struct LightNode
+    {
+        int x, y, z;
+        unsigned char level;
+    };
+    ChunkMap<Chunk*> chunks;
+    MeshingMode meshingMode = MeshingMode::Naive;
+    VertexFormat vertexFormat = VertexFormat::Standard;
+    double lastBuildMilliseconds = 0.0;
+    std::chrono::steady_clock::time_point buildStart;
+    int meshesInFlight = 0;
+    int generationsInFlight = 0;
+    unsigned int nextMeshVersion = 0;
+    bool streamingEnabled = false;
+    StreamingSettings streaming;
+    int streamCenterX = 0;
+    int streamCenterZ = 0;
+    std::vector<StreamCandidate> streamCandidates;
+    std::vector<ChunkPos> streamUnloads;
+    std::mutex completedMutex;
+    std::deque<CompletedMesh> completedMeshes;
+    std::vector<ChunkPos> generatedChunks;
+    std::vector<ChunkPos> releasedMeshes;
+    ChunkMeshData emptyMesh;
+    std::unique_ptr<TerrainGenerator> generator = TerrainGenerator::CreateClassic();
+    std::unique_ptr<RegionStore> regionStore;
+    bool saveGeneratedChunks = false;
+    std::atomic<int> chunksFromDisk {0};
+    int skippedMeshes = 0;
+    std::vector<ChunkPos> dirtyChunks;
+    std::vector<std::shared_ptr<MeshScratch>> spareScratch;
+    bool occlusionCulling = true;
+    bool occlusionValid = false;
+    ChunkPos occlusionMin = {0, 0, 0};
+    ChunkPos occlusionMax = {0, 0, 0};
+    std::vector<unsigned char> occlusionEntered;
+    std::vector<OcclusionStep> occlusionQueue;
+    std::vector<LightNode> lightQueue;
+    std::vector<LightNode> lightRemovals;
+    ChunkPos lightCachePos = {INT_MIN, INT_MIN, INT_MIN};
+    Chunk* lightCacheChunk = nullptr;
+    JobSystem jobs;
+    Chunk* FindChunk(int cx, int cy, int cz)
+    {
+        Chunk** c = chunks.Find(cx, cy, cz);
+        return c ? *c : nullptr;
+    }
+    void QueueChunkGeneration(int cx, int cy, int cz)
     {
-        position = {(float)cx * CHUNK_SIZE, (float)cy * CHUNK_SIZE, (float)cz * CHUNK_SIZE};
-        for (int x = 0; x < CHUNK_SIZE; x++)
+        Chunk* c = new Chunk();
+        chunks[{cx, cy, cz}] = c;
+        generationsInFlight++;
+        jobs.Submit([this, c, cx, cy, cz]
+            {
+                unsigned char stored[Size][Size][Size];
+                if (regionStore && regionStore->Load({cx, cy, cz}, stored))
+                {
+                    c->voxels.Assign(stored);
+                    chunksFromDisk++;
+                }
+                else
+                {
+                    c->GenerateData(cx, cy, cz, *generator);
+                    c->needsSave = saveGeneratedChunks && regionStore;
+                }
+                std::lock_guard<std::mutex> lock(completedMutex);
+                generatedChunks.push_back({cx, cy, cz});
+            });
+    }
+    // A freshly generated chunk changes the face culling and AO at its neighbors' borders.
+    void CollectGeneratedChunks()
+    {
+        std::vector<ChunkPos> ready;
+        {
+            std::lock_guard<std::mutex> lock(completedMutex);
+            ready.swap(generatedChunks);
+        }
+        for (const ChunkPos& pos : ready)
         {
-            for (int z = 0; z < CHUNK_SIZE; z++)
+            Chunk* chunk = FindChunk(pos.x, pos.y, pos.z);
+            generationsInFlight--;
+            if (!chunk) continue;
+            chunk->isGenerated = true;
+            for (int dx = -1; dx <= 1; dx++)
             {
-                float worldX = (float)(cx * CHUNK_SIZE + x);
-                float worldZ = (float)(cz * CHUNK_SIZE + z);
-                float noise = stb_perlin_noise3(worldX * 0.03f, 0.0f, worldZ * 0.03f, 0, 0, 0);
-                int worldHeight = (int)(8 + noise * 10);
-                for (int y = 0; y < CHUNK_SIZE; y++)
+                for (int dy = -1; dy <= 1; dy++)
                 {
-                    float worldY = (float)(cy * CHUNK_SIZE + y);
-                    voxels[x][y][z] = (worldY < worldHeight) ? 1 : 0;
+                    for (int dz = -1; dz <= 1; dz++)
+                    {
+                        Chunk* neighbor = FindChunk(pos.x + dx, pos.y + dy, pos.z + dz);
+                        if (neighbor && neighbor->isGenerated) neighbor->isModified = true;
+                    }
                 }
             }
+            LightChunk(pos, chunk);
         }
     }
-};
-class ChunkManager
-{
-private:
-    std::map<ChunkPos, Chunk*> chunks;
-    Texture2D worldTexture;
-    void BuildChunkMesh(int cx, int cy, int cz)
+    bool IsInStreamingRange(int cx, int cy, int cz) const
+    {
+        if (cy < streaming.minChunkY || cy > streaming.maxChunkY) return false;
+        int dx = cx - streamCenterX;
+        int dz = cz - streamCenterZ;
+        return dx * dx + dz * dz <= streaming.loadRadius * streaming.loadRadius;
+    }
+    // Meshing waits until every neighbor that will exist has its voxels, so borders are built once.
+    bool AreNeighborsSettled(int cx, int cy, int cz)
+    {
+        for (int dx = -1; dx <= 1; dx++)
+        {
+            for (int dy = -1; dy <= 1; dy++)
+            {
+                for (int dz = -1; dz <= 1; dz++)
+                {
+                    Chunk* neighbor = FindChunk(cx + dx, cy + dy, cz + dz);
+                    if (neighbor ? !neighbor->isGenerated : IsInStreamingRange(cx + dx, cy + dy, cz + dz)) return false;
+                }
+            }
+        }
+        return true;
+    }
+    int SelectLod(int cx, int cz, int current) const
+    {
+        int dx = cx - streamCenterX;
+        int dz = cz - streamCenterZ;
+        float distance = sqrtf((float)(dx * dx + dz * dz));
+        int lod = current;
+        while (lod > 0 && distance < streaming.lodDistances[lod - 1] - streaming.lodHysteresis) lod--;
+        while (lod < CHUNK_LOD_LEVELS - 1 && distance > streaming.lodDistances[lod] + streaming.lodHysteresis) lod++;
+        return lod;
+    }
+    // Face neighbors read this chunk's level when they gather their halo, so they rebuild too.
+    void UpdateLevelsOfDetail()
+    {
+        for (auto const& [coords, c] : chunks)
+        {
+            int lod = SelectLod(coords.x, coords.z, c->lod);
+            if (lod == c->lod) continue;
+            c->lod = lod;
+            if (!c->isGenerated) continue;
+            c->isModified = true;
+            for (const auto& offset : FaceOffsets)
+            {
+                Chunk* neighbor = FindChunk(coords.x + offset[0], coords.y + offset[1], coords.z + offset[2]);
+                if (neighbor && neighbor->isGenerated) neighbor->isModified = true;
+            }
+        }
+    }
+    // One cell of 1 << lod voxels with its origin at local (x, y, z): the most common solid id
+    // when at least half the voxels are solid, else air.
+    static unsigned char DownsampleCell(const Chunk* chunk, int x, int y, int z, int lod)
+    {
+        if (!chunk) return 0;
+        if (lod == 0) return chunk->voxels.Get(x, y, z);
+        unsigned char value;
+        if (chunk->voxels.IsUniform(value)) return value;
+        int size = 1 << lod;
+        unsigned char ids[8];
+        int counts[8];
+        int distinct = 0;
+        int solid = 0;
+        for (int i = 0; i < size; i++)
+        {
+            for (int j = 0; j < size; j++)
+            {
+                for (int k = 0; k < size; k++)
+                {
+                    unsigned char block = chunk->voxels.Get(x + i, y + j, z + k);
+                    if (block == 0) continue;
+                    solid++;
+                    int slot = 0;
+                    while (slot < distinct && ids[slot] != block) slot++;
+                    if (slot == distinct)
+                    {
+                        if (distinct == 8) continue;
+                        ids[distinct] = block;
+                        counts[distinct++] = 0;
+                    }
+                    counts[slot]++;
+                }
+            }
+        }
+        if (solid * 2 < size * size * size) return 0;
+        int best = 0;
+        for (int slot = 1; slot < distinct; slot++)
+        {
+            if (counts[slot] > counts[best]) best = slot;
+        }
+        return ids[best];
+    }
+    int OcclusionIndex(const ChunkPos& pos) const
+    {
+        int height = occlusionMax.y - occlusionMin.y + 1;
+        int depth = occlusionMax.z - occlusionMin.z + 1;
+        return ((pos.x - occlusionMin.x) * height + (pos.y - occlusionMin.y)) * depth + (pos.z - occlusionMin.z);
+    }
+    bool InOcclusionBounds(const ChunkPos& pos) const
+    {
+        return pos.x >= occlusionMin.x && pos.x <= occlusionMax.x && pos.y >= occlusionMin.y && pos.y <= occlusionMax.y &&
+            pos.z >= occlusionMin.z && pos.z <= occlusionMax.z;
+    }
+    // Main thread only, like every mesh upload.
+    std::shared_ptr<MeshScratch> AcquireScratch()
+    {
+        if (spareScratch.empty()) return std::make_shared<MeshScratch>();
+        std::shared_ptr<MeshScratch> scratch = std::move(spareScratch.back());
+        spareScratch.pop_back();
+        return scratch;
+    }
+    void RecycleScratch(std::shared_ptr<MeshScratch> scratch)
+    {
+        if (spareScratch.size() < MaxSpareScratch) spareScratch.push_back(std::move(scratch));
+    }
+    void SaveChunk(const ChunkPos& pos, const Chunk& chunk)
+    {
+        unsigned char expanded[Size][Size][Size];
+        chunk.voxels.CopyTo(expanded);
+        regionStore->SaveAsync(pos, expanded);
+    }
+    // A uniform chunk has no faces when it is air, or when it is solid and all six face
+    // neighbors are uniformly solid too; those skip gathering and meshing entirely.
+    bool IsMeshTriviallyEmpty(int cx, int cy, int cz, const Chunk& chunk)
+    {
+        unsigned char value;
+        if (!chunk.voxels.IsUniform(value)) return false;
+        if (value == 0) return true;
+        for (const auto& offset : FaceOffsets)
+        {
+            Chunk* neighbor = GetChunk(cx + offset[0], cy + offset[1], cz + offset[2]);
+            unsigned char neighborValue;
+            if (!neighbor || !neighbor->voxels.IsUniform(neighborValue) || neighborValue == 0) return false;
+        }
+        return true;
+    }
+    void UnloadChunk(const ChunkPos& pos)
+    {
+        Chunk* chunk = FindChunk(pos.x, pos.y, pos.z);
+        if (!chunk) return;
+        releasedMeshes.push_back(pos);
+        if (chunk->needsSave) SaveChunk(pos, *chunk);
+        delete chunk;
+        chunks.Erase(pos);
+    }
+    // Starts a new mesh version for the chunk, which makes any build still in flight stale.
+    // Returns false when there is nothing to build, so the new mesh is empty.
+    bool BeginChunkMesh(Chunk* chunk, int cx, int cy, int cz)
+    {
+        VoxelData::PrecomputeAO();
+        chunk->meshVersion = ++nextMeshVersion;
+        chunk->isModified = false;
+        if (!IsMeshTriviallyEmpty(cx, cy, cz, *chunk)) return true;
+        unsigned char value;
+        chunk->voxels.IsUniform(value);
+        chunk->visibility = value == 0 ? ChunkVisibility::Open() : ChunkVisibility::Closed();
+        skippedMeshes++;
+        return false;
+    }
+    // The neighborhood is copied on this thread, so the job never touches shared chunk data.
+    // A chunk with nothing to build still queues its empty mesh, in order with the others.
+    void QueueChunkMesh(int cx, int cy, int cz)
+    {
+        Chunk* chunk = GetChunk(cx, cy, cz);
+        if (!chunk) return;
+        if (!BeginChunkMesh(chunk, cx, cy, cz))
+        {
+            meshesInFlight++;
+            std::lock_guard<std::mutex> lock(completedMutex);
+            completedMeshes.push_back({{cx, cy, cz}, chunk->meshVersion, nullptr});
+            return;
+        }
+        unsigned int version = chunk->meshVersion;
+        std::shared_ptr<MeshScratch> scratch = AcquireScratch();
+        int lod = chunk->lod;
+        GatherLodNeighborhood(cx, cy, cz, lod, scratch->voxels);
+        GatherLightNeighborhood(cx, cy, cz, lod, scratch->light);
+        MeshingMode mode = meshingMode;
+        VertexFormat format = vertexFormat;
+        meshesInFlight++;
+        jobs.Submit([this, cx, cy, cz, version, mode, format, lod, scratch]
+            {
+                ChunkMeshBuilder::BuildMeshData(scratch->voxels, scratch->light, mode, format, lod, scratch->data);
+                scratch->visibility = ChunkVisibility::Compute(scratch->voxels, Size >> lod);
+                std::lock_guard<std::mutex> lock(completedMutex);
+                completedMeshes.push_back({{cx, cy, cz}, version, scratch});
+            });
+    }
+    // Hands a finished mesh to upload(pos, data), which returns the bytes it sent, unless the
+    // chunk has been remeshed or unloaded since the build started.
+    template <typename Upload>
+    size_t DeliverMesh(const CompletedMesh& done, Upload& upload)
+    {
+        Chunk* chunk = FindChunk(done.pos.x, done.pos.y, done.pos.z);
+        if (!chunk || chunk->meshVersion != done.version) return 0;
+        if (!done.scratch) return upload(done.pos, emptyMesh);
+        chunk->visibility = done.scratch->visibility;
+        return upload(done.pos, done.scratch->data);
+    }
+    // Edits touch a handful of chunks, so they are rebuilt here rather than on the job queue.
+    template <typename Upload>
+    void BuildChunkMeshNow(int cx, int cy, int cz, UploadStats& stats, Upload& upload)
+    {
+        Chunk* chunk = GetChunk(cx, cy, cz);
+        if (!chunk) return;
+        if (!BeginChunkMesh(chunk, cx, cy, cz))
+        {
+            DeliverMesh({{cx, cy, cz}, chunk->meshVersion, nullptr}, upload);
+            return;
+        }
+        std::shared_ptr<MeshScratch> scratch = AcquireScratch();
+        GatherLodNeighborhood(cx, cy, cz, chunk->lod, scratch->voxels);
+        GatherLightNeighborhood(cx, cy, cz, chunk->lod, scratch->light);
+        ChunkMeshBuilder::BuildMeshData(scratch->voxels, scratch->light, meshingMode, vertexFormat, chunk->lod, scratch->data);
+        scratch->visibility = ChunkVisibility::Compute(scratch->voxels, Size >> chunk->lod);
+        stats.meshes++;
+        stats.bytes += DeliverMesh({{cx, cy, cz}, chunk->meshVersion, scratch}, upload);
+        RecycleScratch(std::move(scratch));
+    }
+    void MarkDirty(int cx, int cy, int cz)
     {
-        auto it = chunks.find({cx, cy, cz});
-        if (it == chunks.end()) return;
-        unsigned char neighborData[CHUNK_SIZE + 2][CHUNK_SIZE + 2][CHUNK_SIZE + 2] = {0};
-        for (int x = -1; x <= CHUNK_SIZE; x++)
+        Chunk* chunk = GetChunk(cx, cy, cz);
+        if (!chunk || chunk->isModified) return;
+        chunk->isModified = true;
+        dirtyChunks.push_back({cx, cy, cz});
+    }
+    // Marks the owning chunk plus every neighbor that shares the voxel's border (faces, edges and
+    // corners all feed AO and smooth light).
+    void MarkVoxelDirty(int wx, int wy, int wz)
+    {
+        int cx = wx >> Shift;
+        int cy = wy >> Shift;
+        int cz = wz >> Shift;
+        int lx = wx & Mask;
+        int ly = wy & Mask;
+        int lz = wz & Mask;
+        int borderX = lx == 0 ? -1 : (lx == Mask ? 1 : 0);
+        int borderY = ly == 0 ? -1 : (ly == Mask ? 1 : 0);
+        int borderZ = lz == 0 ? -1 : (lz == Mask ? 1 : 0);
+        for (int dx = std::min(borderX, 0); dx <= std::max(borderX, 0); dx++)
         {
-            for (int y = -1; y <= CHUNK_SIZE; y++)
+            for (int dy = std::min(borderY, 0); dy <= std::max(borderY, 0); dy++)
             {
-                for (int z = -1; z <= CHUNK_SIZE; z++)
+                for (int dz = std::min(borderZ, 0); dz <= std::max(borderZ, 0); dz++)
                 {
-                    if (IsBlockAt(
-                        (float)(cx * CHUNK_SIZE + x) + 0.5f,
-                        (float)(cy * CHUNK_SIZE + y) + 0.5f,
-                        (float)(cz * CHUNK_SIZE + z) + 0.5f))
+                    MarkDirty(cx + dx, cy + dy, cz + dz);
+                }
+            }
+        }
+    }
+    // Light updates walk voxel by voxel and mostly stay inside one chunk, so the last chunk found
+    // is remembered. Each update starts with ResetLightCache, as chunks may have loaded since.
+    void ResetLightCache()
+    {
+        lightCachePos = {INT_MIN, INT_MIN, INT_MIN};
+        lightCacheChunk = nullptr;
+    }
+    Chunk* LightChunkAt(int wx, int wy, int wz)
+    {
+        ChunkPos pos = {wx >> Shift, wy >> Shift, wz >> Shift};
+        if (!(pos == lightCachePos))
+        {
+            lightCachePos = pos;
+            lightCacheChunk = GetChunk(pos.x, pos.y, pos.z);
+        }
+        return lightCacheChunk;
+    }
+    // Sunlight enters the top of a chunk that has nothing above it and never will; a layer that
+    // is still streaming in stays dark until it arrives and shines down.
+    bool OpensToSky(int cx, int cy, int cz)
+    {
+        return !FindChunk(cx, cy + 1, cz) && !IsInStreamingRange(cx, cy + 1, cz);
+    }
+    void WriteLight(Chunk* chunk, int wx, int wy, int wz, unsigned char value)
+    {
+        int lx = wx & Mask;
+        int ly = wy & Mask;
+        int lz = wz & Mask;
+        chunk->light.Set(lx, ly, lz, value);
+        bool border = lx == 0 || lx == Mask || ly == 0 || ly == Mask || lz == 0 || lz == Mask;
+        if (border || !chunk->isModified) MarkVoxelDirty(wx, wy, wz);
+    }
+    // Breadth-first spread of one channel from every voxel on lightQueue into the air around it,
+    // across chunk borders, by the rules of ChunkLight::SpreadLevel.
+    void PropagateLight(int shift)
+    {
+        for (size_t head = 0; head < lightQueue.size(); head++)
+        {
+            LightNode node = lightQueue[head];
+            Chunk* chunk = LightChunkAt(node.x, node.y, node.z);
+            if (!chunk) continue;
+            int level = (chunk->light.Get(node.x & Mask, node.y & Mask, node.z & Mask) >> shift) & ChunkLight::MaxLevel;
+            if (level <= 1) continue;
+            for (int face = 0; face < 6; face++)
+            {
+                int nx = node.x + FaceOffsets[face][0];
+                int ny = node.y + FaceOffsets[face][1];
+                int nz = node.z + FaceOffsets[face][2];
+                Chunk* neighbor = LightChunkAt(nx, ny, nz);
+                if (!neighbor || neighbor->voxels.Get(nx & Mask, ny & Mask, nz & Mask) != 0) continue;
+                int spread = ChunkLight::SpreadLevel(shift, face, level);
+                unsigned char packed = neighbor->light.Get(nx & Mask, ny & Mask, nz & Mask);
+                if (((packed >> shift) & ChunkLight::MaxLevel) >= spread) continue;
+                WriteLight(neighbor, nx, ny, nz, (unsigned char)((packed & ~(ChunkLight::MaxLevel << shift)) | spread << shift));
+                lightQueue.push_back({nx, ny, nz, 0});
+            }
+        }
+        lightQueue.clear();
+    }
+    // Clears one channel outward from every voxel on lightRemovals, whose level is what the voxel
+    // held before. A neighbor dimmer than that (or a full-sun column below it) was lit through the
+    // voxel and goes dark in turn; a neighbor at least as bright has another source, so it is
+    // queued to shine back into the cleared area by the next PropagateLight.
+    void UnpropagateLight(int shift)
+    {
+        for (size_t head = 0; head < lightRemovals.size(); head++)
+        {
+            LightNode node = lightRemovals[head];
+            for (int face = 0; face < 6; face++)
+            {
+                int nx = node.x + FaceOffsets[face][0];
+                int ny = node.y + FaceOffsets[face][1];
+                int nz = node.z + FaceOffsets[face][2];
+                Chunk* neighbor = LightChunkAt(nx, ny, nz);
+                if (!neighbor) continue;
+                int lx = nx & Mask;
+                int ly = ny & Mask;
+                int lz = nz & Mask;
+                unsigned char packed = neighbor->light.Get(lx, ly, lz);
+                int level = (packed >> shift) & ChunkLight::MaxLevel;
+                if (level == 0) continue;
+                bool litThrough = level < node.level || (shift == ChunkLight::SunShift && face == 3 && node.level == ChunkLight::MaxLevel);
+                if (!litThrough)
+                {
+                    lightQueue.push_back({nx, ny, nz, 0});
+                    continue;
+                }
+                int source = shift == ChunkLight::BlockShift ? BlockLightEmission(neighbor->voxels.Get(lx, ly, lz)) : 0;
+                WriteLight(neighbor, nx, ny, nz, (unsigned char)((packed & ~(ChunkLight::MaxLevel << shift)) | source << shift));
+                lightRemovals.push_back({nx, ny, nz, (unsigned char)level});
+                if (source > 0) lightQueue.push_back({nx, ny, nz, 0});
+            }
+        }
+        lightRemovals.clear();
+    }
+    // Brings a chunk's light up to what its own voxels and its loaded neighbors give it: sunlight
+    // straight down each open column when the chunk opens to the sky, block light at emitters,
+    // and the light shining in across each face, all spread through the chunk on local copies.
+    // Light never goes down here, so this serves both chunks that just arrived and chunks a
+    // neighbor has brightened. Afterwards light crosses back out through the faces: a neighbor
+    // with many voxels to brighten is relit the same way, a few voxels go through
+    // PropagateLight. Light that came from a chunk that has since unloaded stays where it is.
+    void LightChunk(const ChunkPos& pos, Chunk* chunk)
+    {
+        const int shifts[2] = {ChunkLight::SunShift, ChunkLight::BlockShift};
+        const int relightThreshold = 64;
+        unsigned char blocks[Size][Size][Size];
+        unsigned char levels[Size][Size][Size];
+        unsigned char previous[Size][Size][Size];
+        chunk->voxels.CopyTo(blocks);
+        chunk->light.CopyTo(&previous[0][0][0]);
+        memcpy(levels, previous, sizeof(levels));
+        bool sky = OpensToSky(pos.x, pos.y, pos.z);
+        for (int x = 0; x < Size; x++)
+        {
+            for (int z = 0; z < Size; z++)
+            {
+                bool lit = sky;
+                for (int y = Mask; y >= 0; y--)
+                {
+                    unsigned char block = blocks[x][y][z];
+                    lit = lit && block == 0;
+                    int sun = std::max(ChunkLight::Sun(levels[x][y][z]), lit ? ChunkLight::MaxLevel : 0);
+                    int emitted = std::max(ChunkLight::Block(levels[x][y][z]), BlockLightEmission(block));
+                    levels[x][y][z] = ChunkLight::Pack(sun, emitted);
+                }
+            }
+        }
+        Chunk* neighbors[6];
+        for (int face = 0; face < 6; face++)
+        {
+            neighbors[face] = GetChunk(pos.x + FaceOffsets[face][0], pos.y + FaceOffsets[face][1], pos.z + FaceOffsets[face][2]);
+            if (!neighbors[face]) continue;
+            ForEachFacePair(face, [&](const int inside[3], const int outside[3])
+                {
+                    unsigned char& level = levels[inside[0]][inside[1]][inside[2]];
+                    if (blocks[inside[0]][inside[1]][inside[2]] != 0) return;
+                    unsigned char incoming = neighbors[face]->light.Get(outside[0], outside[1], outside[2]);
+                    int sun = std::max(ChunkLight::Sun(level), ChunkLight::SpreadLevel(ChunkLight::SunShift, face ^ 1, ChunkLight::Sun(incoming)));
+                    int block = std::max(ChunkLight::Block(level), ChunkLight::Block(incoming) - 1);
+                    level = ChunkLight::Pack(sun, block);
+                });
+        }
+        for (int shift : shifts) ChunkLight::SpreadInside(blocks, levels, shift);
+        if (memcmp(levels, previous, sizeof(levels)) == 0) return;
+        chunk->light.Assign(&levels[0][0][0]);
+        // Every chunk whose mesh reads a changed voxel, this one or a neighbor through its halo.
+        bool touched[3][3][3] = {};
+        for (int x = 0; x < Size; x++)
+        {
+            for (int y = 0; y < Size; y++)
+            {
+                for (int z = 0; z < Size; z++)
+                {
+                    if (levels[x][y][z] == previous[x][y][z]) continue;
+                    int sx = x == 0 ? 0 : (x == Mask ? 2 : 1);
+                    int sy = y == 0 ? 0 : (y == Mask ? 2 : 1);
+                    int sz = z == 0 ? 0 : (z == Mask ? 2 : 1);
+                    for (int dx = std::min(sx, 1); dx <= std::max(sx, 1); dx++)
                     {
-                        neighborData[x + 1][y + 1][z + 1] = 1;
+                        for (int dy = std::min(sy, 1); dy <= std::max(sy, 1); dy++)
+                        {
+                            for (int dz = std::min(sz, 1); dz <= std::max(sz, 1); dz++) touched[dx][dy][dz] = true;
+                        }
                     }
                 }
             }
         }
-        if (it->second->model.meshCount > 0) UnloadModel(it->second->model);
-        Mesh mesh = ChunkMeshBuilder::GenerateMesh(neighborData);
-        it->second->model = LoadModelFromMesh(mesh);
-        it->second->model.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = worldTexture;
+        for (int dx = 0; dx < 3; dx++)
+        {
+            for (int dy = 0; dy < 3; dy++)
+            {
+                for (int dz = 0; dz < 3; dz++)
+                {
+                    if (touched[dx][dy][dz]) MarkDirty(pos.x + dx - 1, pos.y + dy - 1, pos.z + dz - 1);
+                }
+            }
+        }
+        const int base[3] = {pos.x * Size, pos.y * Size, pos.z * Size};
+        for (int face = 0; face < 6; face++)
+        {
+            Chunk* neighbor = neighbors[face];
+            if (!neighbor) continue;
+            int brighter = 0;
+            ForEachFacePair(face, [&](const int inside[3], const int outside[3])
+                {
+                    unsigned char level = chunk->light.Get(inside[0], inside[1], inside[2]);
+                    unsigned char reached = neighbor->light.Get(outside[0], outside[1], outside[2]);
+                    if (neighbor->voxels.Get(outside[0], outside[1], outside[2]) != 0) return;
+                    bool sun = ChunkLight::Sun(reached) < ChunkLight::SpreadLevel(ChunkLight::SunShift, face, ChunkLight::Sun(level));
+                    bool block = ChunkLight::Block(reached) < ChunkLight::Block(level) - 1;
+                    brighter += sun || block;
+                });
+            if (brighter == 0) continue;
+            ChunkPos next = {pos.x + FaceOffsets[face][0], pos.y + FaceOffsets[face][1], pos.z + FaceOffsets[face][2]};
+            if (brighter >= relightThreshold)
+            {
+                LightChunk(next, neighbor);
+                continue;
+            }
+            ResetLightCache();
+            for (int shift : shifts)
+            {
+                ForEachFacePair(face, [&](const int inside[3], const int*)
+                    {
+                        lightQueue.push_back({base[0] + inside[0], base[1] + inside[1], base[2] + inside[2], 0});
+                    });
+                PropagateLight(shift);
+            }
+        }
+    }
+    // Calls visit(inside, outside) for the Size^2 pairs of local coordinates that touch
+    // across face: inside in this chunk, outside in the neighbor.
+    template <typename Visit>
+    static void ForEachFacePair(int face, Visit&& visit)
+    {
+        int axis = face >> 1;
+        int a1 = (axis + 1) % 3;
+        int a2 = (axis + 2) % 3;
+        int inside[3];
+        int outside[3];
+        inside[axis] = (face & 1) ? 0 : Mask;
+        outside[axis] = (face & 1) ? Mask : 0;
+        for (int u = 0; u < Size; u++)
+        {
+            for (int v = 0; v < Size; v++)
+            {
+                inside[a1] = outside[a1] = u;
+                inside[a2] = outside[a2] = v;
+                visit(inside, outside);
+            }
+        }
+    }
+    // Brings light up to date after the voxel at (wx, wy, wz) became block, one channel at a
+    // time: whatever the voxel held beyond what it now gives off is removed outward, then the
+    // voxel and its surroundings shine back in.
+    void RelightVoxel(Chunk* chunk, int wx, int wy, int wz, unsigned char block)
+    {
+        ResetLightCache();
+        bool sky = block == 0 && (wy & Mask) == Mask && OpensToSky(wx >> Shift, wy >> Shift, wz >> Shift);
+        const int shifts[2] = {ChunkLight::SunShift, ChunkLight::BlockShift};
+        const int sources[2] = {sky ? ChunkLight::MaxLevel : 0, BlockLightEmission(block)};
+        for (int c = 0; c < 2; c++)
+        {
+            int shift = shifts[c];
+            unsigned char packed = chunk->light.Get(wx & Mask, wy & Mask, wz & Mask);
+            int level = (packed >> shift) & ChunkLight::MaxLevel;
+            WriteLight(chunk, wx, wy, wz, (unsigned char)((packed & ~(ChunkLight::MaxLevel << shift)) | sources[c] << shift));
+            if (level > sources[c])
+            {
+                lightRemovals.push_back({wx, wy, wz, (unsigned char)level});
+                UnpropagateLight(shift);
+            }
+            lightQueue.push_back({wx, wy, wz, 0});
+            if (block == 0)
+            {
+                for (const auto& offset : FaceOffsets) lightQueue.push_back({wx + offset[0], wy + offset[1], wz + offset[2], 0});
+            }
+            PropagateLight(shift);
+        }
     }
 public:
-    ~ChunkManager()
+    ~BasicChunkManager()
     {
-        UnloadTexture(worldTexture);
+        Shutdown();
+        for (auto const& [coords, c] : chunks) delete c;
     }
-    void InitWorld(int width, int height, int depth)
+    // Finishes the jobs in flight and saves every modified chunk; the destructor does the same.
+    void Shutdown()
+    {
+        jobs.WaitIdle();
+        for (auto const& [coords, c] : chunks)
+        {
+            if (c->needsSave && c->isGenerated) SaveChunk(coords, *c);
+            c->needsSave = false;
+        }
+        if (regionStore) regionStore->Flush();
+    }
+    // Applies to chunks generated from now on; call before InitWorld or EnableStreaming.
+    void SetTerrainGenerator(std::unique_ptr<TerrainGenerator> terrain)
+    {
+        jobs.WaitIdle();
+        generator = std::move(terrain);
+    }
+    // Chunks are loaded from region files under directory when present. Chunks marked needsSave
+    // are written back when they unload or the manager is destroyed; with saveGenerated, freshly
+    // generated chunks are marked too, so revisited areas load instead of regenerating.
+    void EnablePersistence(const std::string& directory, bool saveGenerated)
+    {
+        jobs.WaitIdle();
+        regionStore = std::make_unique<RegionStore>(directory);
+        saveGeneratedChunks = saveGenerated;
+    }
+    // Voxel data only, without queueing any meshes.
+    void GenerateWorld(int width, int height, int depth)
     {
-        worldTexture = LoadTexture("resources/my_texture.png");
         for (int x = 0; x < width; x++)
         {
             for (int y = 0; y < height; y++)
             {
                 for (int z = 0; z < depth; z++)
                 {
-                    Chunk* c = new Chunk();
-                    c->GenerateData(x, y, z);
-                    chunks[{x, y, z}] = c;
+                    QueueChunkGeneration(x, y, z);
                 }
             }
         }
-        for (int x = 0; x < width; x++)
+        jobs.WaitIdle();
+        CollectGeneratedChunks();
+    }
+    void InitWorld(int width, int height, int depth)
+    {
+        GenerateWorld(width, height, depth);
+        RebuildAllMeshes();
+    }
+    void EnableStreaming(const StreamingSettings& settings)
+    {
+        streaming = settings;
+        streamingEnabled = true;
+    }
+    // Called once per frame with the player position and look direction.
+    void UpdateStreaming(Float3 center, Float3 viewDirection)
+    {
+        if (!streamingEnabled) return;
+        CollectGeneratedChunks();
+        streamCenterX = (int)floorf(center.x) >> Shift;
+        streamCenterZ = (int)floorf(center.z) >> Shift;
+        UpdateLevelsOfDetail();
+        streamUnloads.clear();
+        for (auto const& [coords, c] : chunks)
         {
-            for (int y = 0; y < height; y++)
+            if (!c->isGenerated) continue;
+            int dx = coords.x - streamCenterX;
+            int dz = coords.z - streamCenterZ;
+            if (dx * dx + dz * dz > streaming.unloadRadius * streaming.unloadRadius) streamUnloads.push_back(coords);
+        }
+        for (const ChunkPos& pos : streamUnloads) UnloadChunk(pos);
+        generator->EvictOutside(streamCenterX, streamCenterZ, streaming.unloadRadius);
+        Float2 view = {viewDirection.x, viewDirection.z};
+        float viewLength = sqrtf(view.x * view.x + view.y * view.y);
+        if (viewLength > 0.0f) view = {view.x / viewLength, view.y / viewLength};
+        streamCandidates.clear();
+        int radius = streaming.loadRadius;
+        for (int dx = -radius; dx <= radius; dx++)
+        {
+            for (int dz = -radius; dz <= radius; dz++)
             {
-                for (int z = 0; z < depth; z++)
+                if (dx * dx + dz * dz > radius * radius) continue;
+                float distance = sqrtf((float)(dx * dx + dz * dz));
+                float facing = distance > 0.0f ? (dx * view.x + dz * view.y) / distance : 1.0f;
+                float priority = distance * (1.5f - 0.5f * facing);
+                for (int cy = streaming.minChunkY; cy <= streaming.maxChunkY; cy++)
                 {
-                    BuildChunkMesh(x, y, z);
+                    int cx = streamCenterX + dx;
+                    int cz = streamCenterZ + dz;
+                    if (!FindChunk(cx, cy, cz)) streamCandidates.push_back({{cx, cy, cz}, priority});
                 }
             }
         }
+        int budget = std::min(streaming.maxGenerationsPerFrame, streaming.maxGenerationsInFlight - generationsInFlight);
+        size_t loads = std::min(streamCandidates.size(), (size_t)std::max(budget, 0));
+        std::partial_sort(streamCandidates.begin(), streamCandidates.begin() + loads, streamCandidates.end(),
+            [](const StreamCandidate& a, const StreamCandidate& b) { return a.priority < b.priority; });
+        for (size_t i = 0; i < loads; i++)
+        {
+            const ChunkPos& pos = streamCandidates[i].pos;
+            QueueChunkGeneration(pos.x, pos.y, pos.z);
+        }
+        for (auto const& [coords, c] : chunks)
+        {
+            if (c->isGenerated && c->isModified && AreNeighborsSettled(coords.x, coords.y, coords.z))
+            {
+                QueueChunkMesh(coords.x, coords.y, coords.z);
+            }
+        }
     }
-    void DrawWorld(Shader shadowShader = {0})
+    // True once every streamed layer of the column containing (wx, wz) has voxel data.
+    bool IsColumnLoaded(float wx, float wz)
     {
+        int cx = (int)floorf(wx) >> Shift;
+        int cz = (int)floorf(wz) >> Shift;
+        int minY = streamingEnabled ? streaming.minChunkY : 0;
+        int maxY = streamingEnabled ? streaming.maxChunkY : 0;
+        for (int cy = minY; cy <= maxY; cy++)
+        {
+            Chunk* c = GetChunk(cx, cy, cz);
+            if (!c || !c->isGenerated) return false;
+        }
+        return true;
+    }
+    void RebuildAllMeshes()
+    {
+        buildStart = std::chrono::steady_clock::now();
         for (auto const& [coords, c] : chunks)
         {
-            if (shadowShader.id != 0)
+            if (c->isGenerated) QueueChunkMesh(coords.x, coords.y, coords.z);
+        }
+    }
+    // Hands finished meshes to upload(pos, data) until the budget is spent; at least one per call
+    // so progress is guaranteed. Call TakeReleasedMeshes first, so a chunk unloaded and loaded
+    // again drops its old mesh before receiving a new one.
+    template <typename Upload>
+    UploadStats ProcessMeshes(double budgetMilliseconds, Upload&& upload)
+    {
+        UploadStats stats;
+        auto start = std::chrono::steady_clock::now();
+        while (meshesInFlight > 0)
+        {
+            CompletedMesh done;
             {
-                c->model.materials[0].shader = shadowShader;
+                std::lock_guard<std::mutex> lock(completedMutex);
+                if (completedMeshes.empty()) break;
+                done = std::move(completedMeshes.front());
+                completedMeshes.pop_front();
             }
-            DrawModel(c->model, c->position, 1.0f, WHITE);
+            if (done.scratch) stats.meshes++;
+            stats.bytes += DeliverMesh(done, upload);
+            if (done.scratch) RecycleScratch(std::move(done.scratch));
+            auto now = std::chrono::steady_clock::now();
+            if (--meshesInFlight == 0)
+            {
+                lastBuildMilliseconds = std::chrono::duration<double, std::milli>(now - buildStart).count();
+            }
+            if (std::chrono::duration<double, std::milli>(now - start).count() >= budgetMilliseconds) break;
         }
+        return stats;
+    }
+    template <typename Upload>
+    void FinishPendingMeshes(Upload&& upload)
+    {
+        jobs.WaitIdle();
+        ProcessMeshes(INFINITY, upload);
+    }
+    // Chunks unloaded since the last call, appended to out; their meshes are gone with them.
+    void TakeReleasedMeshes(std::vector<ChunkPos>& out)
+    {
+        out.insert(out.end(), releasedMeshes.begin(), releasedMeshes.end());
+        releasedMeshes.clear();
+    }
+    MeshingMode GetMeshingMode() const
+    {
+        return meshingMode;
+    }
+    void SetMeshingMode(MeshingMode mode)
+    {
+        if (mode == meshingMode) return;
+        meshingMode = mode;
+        RebuildAllMeshes();
+    }
+    VertexFormat GetVertexFormat() const
+    {
+        return vertexFormat;
+    }
+    void SetVertexFormat(VertexFormat format)
+    {
+        if (format == vertexFormat) return;
+        vertexFormat = format;
+        RebuildAllMeshes();
+    }
+    bool GetOcclusionCulling() const
+    {
+        return occlusionCulling;
+    }
+    void SetOcclusionCulling(bool enabled)
+    {
+        occlusionCulling = enabled;
+        occlusionValid = false;
+    }
+    // Finds the chunks that may be visible from eye: a breadth-first walk out of the eye's chunk
+    // that only leaves a chunk through a face its air connects to the face it came in by, never
+    // turns back against a direction it has already taken, and stays inside the frustum. Cells
+    // with no chunk (the sky above the streamed layers, columns still loading) count as open air.
+    // Each chunk is walked once per face it is entered through. Everything else is occluded
+    // until the next call.
+    void UpdateOcclusion(Float3 eye, const Frustum& frustum)
+    {
+        occlusionValid = false;
+        if (!occlusionCulling || chunks.Size() == 0) return;
+        ChunkPos start = {(int)floorf(eye.x) >> Shift, (int)floorf(eye.y) >> Shift, (int)floorf(eye.z) >> Shift};
+        occlusionMin = start;
+        occlusionMax = start;
+        for (auto const& [coords, c] : chunks)
+        {
+            occlusionMin = {std::min(occlusionMin.x, coords.x - 1), std::min(occlusionMin.y, coords.y - 1), std::min(occlusionMin.z, coords.z - 1)};
+            occlusionMax = {std::max(occlusionMax.x, coords.x + 1), std::max(occlusionMax.y, coords.y + 1), std::max(occlusionMax.z, coords.z + 1)};
+        }
+        size_t cells = (size_t)(occlusionMax.x - occlusionMin.x + 1) * (occlusionMax.y - occlusionMin.y + 1) * (occlusionMax.z - occlusionMin.z + 1);
+        occlusionEntered.assign(cells, 0);
+        occlusionQueue.clear();
+        occlusionEntered[OcclusionIndex(start)] = ChunkVisibility::AllFaces;
+        for (int face = 0; face < ChunkVisibility::FaceCount; face++)
+        {
+            occlusionQueue.push_back({{start.x + FaceOffsets[face][0], start.y + FaceOffsets[face][1], start.z + FaceOffsets[face][2]}, face ^ 1, (unsigned char)(1 << face)});
+        }
+        for (size_t head = 0; head < occlusionQueue.size(); head++)
+        {
+            OcclusionStep step = occlusionQueue[head];
+            if (!InOcclusionBounds(step.pos)) continue;
+            if (!frustum.IntersectsBox(ChunkBounds<Shift>(step.pos))) continue;
+            unsigned char& entered = occlusionEntered[OcclusionIndex(step.pos)];
+            if ((entered >> step.face) & 1) continue;
+            entered |= 1 << step.face;
+            Chunk* chunk = FindChunk(step.pos.x, step.pos.y, step.pos.z);
+            unsigned char exits = chunk ? chunk->visibility.connections[step.face] : ChunkVisibility::AllFaces;
+            for (int face = 0; face < ChunkVisibility::FaceCount; face++)
+            {
+                if (!((exits >> face) & 1) || ((step.directions >> (face ^ 1)) & 1)) continue;
+                ChunkPos next = {step.pos.x + FaceOffsets[face][0], step.pos.y + FaceOffsets[face][1], step.pos.z + FaceOffsets[face][2]};
+                occlusionQueue.push_back({next, face ^ 1, (unsigned char)(step.directions | 1 << face)});
+            }
+        }
+        occlusionValid = true;
+    }
+    // False for everything when the last UpdateOcclusion was skipped.
+    bool IsOccluded(const ChunkPos& pos) const
+    {
+        if (!occlusionValid) return false;
+        return !InOcclusionBounds(pos) || occlusionEntered[OcclusionIndex(pos)] == 0;
+    }
+    // The meshing side only; ChunkRenderer::GetMeshStats adds what is on the GPU.
+    MeshStats GetMeshStats()
+    {
+        MeshStats stats;
+        stats.pendingMeshes = meshesInFlight;
+        stats.loadedChunks = (int)chunks.Size();
+        stats.buildMilliseconds = lastBuildMilliseconds;
+        stats.chunksFromDisk = chunksFromDisk;
+        stats.pendingSaves = regionStore ? regionStore->PendingSaves() : 0;
+        return stats;
+    }
+    VoxelMemoryStats GetVoxelMemoryStats()
+    {
+        VoxelMemoryStats stats;
+        for (auto const& [coords, c] : chunks)
+        {
+            if (!c->isGenerated) continue;
+            int mode = (int)c->voxels.GetMode();
+            stats.chunks[mode]++;
+            stats.bytes[mode] += c->voxels.ResidentBytes();
+            stats.lightBytes += c->light.ResidentBytes();
+        }
+        stats.skippedMeshes = skippedMeshes;
+        return stats;
+    }
+    // Only chunks whose voxel data is complete; chunks still being generated read as missing.
+    Chunk* GetChunk(int cx, int cy, int cz)
+    {
+        Chunk* c = FindChunk(cx, cy, cz);
+        return (c && c->isGenerated) ? c : nullptr;
+    }
+    unsigned char GetBlock(int wx, int wy, int wz)
+    {
+        Chunk* c = GetChunk(wx >> Shift, wy >> Shift, wz >> Shift);
+        return c ? c->voxels.Get(wx & Mask, wy & Mask, wz & Mask) : 0;
     }
     bool IsBlockAt(float wx, float wy, float wz)
     {
-        int cx = (int)floor(wx / CHUNK_SIZE);
-        int cy = (int)floor(wy / CHUNK_SIZE);
-        int cz = (int)floor(wz / CHUNK_SIZE);
-        auto it = chunks.find({cx, cy, cz});
-        if (it != chunks.end())
+        return GetBlock((int)floorf(wx), (int)floorf(wy), (int)floorf(wz)) != 0;
+    }
+    // Amanatides-Woo voxel traversal. The current chunk is resolved once per chunk crossed, and a
+    // chunk that is missing or uniformly air is crossed in one jump to the voxel where the ray
+    // leaves it. direction need not be normalized; distance is in world units.
+    VoxelRayHit Raycast(Float3 origin, Float3 direction, float maxDistance)
+    {
+        VoxelRayHit result;
+        float length = sqrtf(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+        if (length == 0.0f) return result;
+        const float start[3] = {origin.x, origin.y, origin.z};
+        const float dir[3] = {direction.x / length, direction.y / length, direction.z / length};
+        int voxel[3], step[3];
+        float tMax[3], tDelta[3];
+        for (int a = 0; a < 3; a++)
+        {
+            voxel[a] = (int)floorf(start[a]);
+            step[a] = dir[a] > 0.0f ? 1 : (dir[a] < 0.0f ? -1 : 0);
+            tDelta[a] = step[a] != 0 ? fabsf(1.0f / dir[a]) : INFINITY;
+            float boundary = step[a] > 0 ? voxel[a] + 1.0f - start[a] : start[a] - voxel[a];
+            tMax[a] = step[a] != 0 ? boundary * tDelta[a] : INFINITY;
+        }
+        int chunkPos[3] = {INT_MIN, INT_MIN, INT_MIN};
+        Chunk* chunk = nullptr;
+        bool chunkEmpty = true;
+        int enteredAxis = -1;
+        float t = 0.0f;
+        while (t <= maxDistance)
+        {
+            int cx = voxel[0] >> Shift;
+            int cy = voxel[1] >> Shift;
+            int cz = voxel[2] >> Shift;
+            if (cx != chunkPos[0] || cy != chunkPos[1] || cz != chunkPos[2])
+            {
+                chunk = GetChunk(cx, cy, cz);
+                chunkPos[0] = cx;
+                chunkPos[1] = cy;
+                chunkPos[2] = cz;
+                unsigned char value;
+                chunkEmpty = !chunk || (chunk->voxels.IsUniform(value) && value == 0);
+            }
+            if (chunkEmpty)
+            {
+                // Advance every axis to its last voxel crossing before the ray leaves the chunk;
+                // the regular step below then crosses into the next chunk.
+                int remaining[3];
+                float tExit = INFINITY;
+                int exitAxis = -1;
+                for (int a = 0; a < 3; a++)
+                {
+                    if (step[a] == 0) continue;
+                    int local = voxel[a] & Mask;
+                    remaining[a] = step[a] > 0 ? Mask - local : local;
+                    float tLeave = tMax[a] + remaining[a] * tDelta[a];
+                    if (tLeave < tExit)
+                    {
+                        tExit = tLeave;
+                        exitAxis = a;
+                    }
+                }
+                if (exitAxis < 0 || tExit > maxDistance) return result;
+                for (int a = 0; a < 3; a++)
+                {
+                    if (step[a] == 0) continue;
+                    int crossings = remaining[a];
+                    if (a != exitAxis) crossings = tMax[a] <= tExit ? std::min((int)((tExit - tMax[a]) / tDelta[a]) + 1, remaining[a]) : 0;
+                    voxel[a] += crossings * step[a];
+                    tMax[a] += crossings * tDelta[a];
+                }
+            }
+            else
+            {
+                unsigned char block = chunk->voxels.Get(voxel[0] & Mask, voxel[1] & Mask, voxel[2] & Mask);
+                if (block != 0)
+                {
+                    result.hit = true;
+                    result.x = voxel[0];
+                    result.y = voxel[1];
+                    result.z = voxel[2];
+                    result.distance = t;
+                    result.block = block;
+                    if (enteredAxis >= 0)
+                    {
+                        // The face the ray came in through looks back along its step.
+                        const int* normal = FaceOffsets[enteredAxis * 2 + (step[enteredAxis] > 0)];
+                        result.normal = {(float)normal[0], (float)normal[1], (float)normal[2]};
+                    }
+                    return result;
+                }
+            }
+            enteredAxis = tMax[0] < tMax[1] ? (tMax[0] < tMax[2] ? 0 : 2) : (tMax[1] < tMax[2] ? 1 : 2);
+            t = tMax[enteredAxis];
+            voxel[enteredAxis] += step[enteredAxis];
+            tMax[enteredAxis] += tDelta[enteredAxis];
+        }
+        return result;
+    }
+    // Marks the owning chunk for remeshing, plus every neighbor that shares the edited voxel's
+    // border, and updates the light around the voxel, marking every chunk whose light changed.
+    // Returns false when the chunk is not loaded or already holds the block. Nothing is rebuilt
+    // until RemeshDirtyChunks.
+    bool SetBlockAt(int wx, int wy, int wz, unsigned char block)
+    {
+        Chunk* chunk = GetChunk(wx >> Shift, wy >> Shift, wz >> Shift);
+        int lx = wx & Mask;
+        int ly = wy & Mask;
+        int lz = wz & Mask;
+        if (!chunk || chunk->voxels.Get(lx, ly, lz) == block) return false;
+        chunk->voxels.Set(lx, ly, lz, block);
+        chunk->needsSave = regionStore != nullptr;
+        MarkVoxelDirty(wx, wy, wz);
+        RelightVoxel(chunk, wx, wy, wz, block);
+        return true;
+    }
+    // Clears and relights every loaded chunk, then marks them all for remeshing. Edits keep the
+    // light current on their own; this is for bulk changes to the voxels.
+    void RecomputeLight()
+    {
+        for (auto const& [coords, c] : chunks) c->light.Fill(0);
+        for (auto const& [coords, c] : chunks)
+        {
+            if (c->isGenerated) LightChunk(coords, c);
+        }
+        for (auto const& [coords, c] : chunks)
         {
-            int lx = (int)floor(wx) - (cx * CHUNK_SIZE);
-            int ly = (int)floor(wy) - (cy * CHUNK_SIZE);
-            int lz = (int)floor(wz) - (cz * CHUNK_SIZE);
-            if (lx >= 0 && lx < CHUNK_SIZE &&
-                ly >= 0 && ly < CHUNK_SIZE &&
-                lz >= 0 && lz < CHUNK_SIZE)
+            if (c->isGenerated) MarkDirty(coords.x, coords.y, coords.z);
+        }
+    }
+    // Called once per frame: every chunk edited since the last call is rebuilt and handed to
+    // upload(pos, data) once, however many edits it received. Chunks whose neighbors are still
+    // streaming in stay dirty and are picked up by UpdateStreaming instead.
+    template <typename Upload>
+    UploadStats RemeshDirtyChunks(Upload&& upload)
+    {
+        UploadStats stats;
+        for (const ChunkPos& pos : dirtyChunks)
+        {
+            Chunk* chunk = GetChunk(pos.x, pos.y, pos.z);
+            if (!chunk || !chunk->isModified) continue;
+            if (streamingEnabled && !AreNeighborsSettled(pos.x, pos.y, pos.z)) continue;
+            BuildChunkMeshNow(pos.x, pos.y, pos.z, stats, upload);
+        }
+        dirtyChunks.clear();
+        return stats;
+    }
+    // Fills the chunk plus a one-voxel halo. The 27 surrounding chunks are resolved once,
+    // then every padded z-row is copied as corner + Size interior bytes + corner.
+    void GatherNeighborhood(int cx, int cy, int cz, unsigned char out[Size + 2][Size + 2][Size + 2])
+    {
+        Chunk* around[3][3][3];
+        for (int dx = 0; dx < 3; dx++)
+        {
+            for (int dy = 0; dy < 3; dy++)
             {
-                return it->second->voxels[lx][ly][lz] != 0;
+                for (int dz = 0; dz < 3; dz++)
+                {
+                    around[dx][dy][dz] = GetChunk(cx + dx - 1, cy + dy - 1, cz + dz - 1);
+                }
             }
         }
-        return false;
+        for (int px = 0; px < Size + 2; px++)
+        {
+            int sx = (px == 0) ? 0 : (px > Size ? 2 : 1);
+            int lx = (px - 1) & Mask;
+            for (int py = 0; py < Size + 2; py++)
+            {
+                int sy = (py == 0) ? 0 : (py > Size ? 2 : 1);
+                int ly = (py - 1) & Mask;
+                unsigned char* row = out[px][py];
+                Chunk* const* line = around[sx][sy];
+                row[0] = line[0] ? line[0]->voxels.Get(lx, ly, Mask) : 0;
+                if (line[1]) line[1]->voxels.CopyRow(lx, ly, row + 1);
+                else memset(row + 1, 0, Size);
+                row[Size + 1] = line[2] ? line[2]->voxels.Get(lx, ly, 0) : 0;
+            }
+        }
+    }
+    // The padded grid of (Size >> lod) cells per axis that BuildMeshData expects at lod.
+    // Interior, edge and corner cells are downsampled at this chunk's level. A face halo cell
+    // instead holds what the neighbor renders there at its own level: the neighbor's cell
+    // containing it when that level is coarser, or air unless every finer neighbor cell along
+    // the face is solid. Both sides of a border between levels then emit a face wherever only
+    // one side is solid, so no gaps open where the two resolutions disagree.
+    void GatherLodNeighborhood(int cx, int cy, int cz, int lod, unsigned char out[Size + 2][Size + 2][Size + 2])
+    {
+        Chunk* around[3][3][3];
+        bool mixed = lod != 0;
+        for (int dx = 0; dx < 3; dx++)
+        {
+            for (int dy = 0; dy < 3; dy++)
+            {
+                for (int dz = 0; dz < 3; dz++)
+                {
+                    around[dx][dy][dz] = GetChunk(cx + dx - 1, cy + dy - 1, cz + dz - 1);
+                }
+            }
+        }
+        for (const auto& offset : FaceOffsets)
+        {
+            const Chunk* neighbor = around[offset[0] + 1][offset[1] + 1][offset[2] + 1];
+            if (neighbor && neighbor->lod != lod) mixed = true;
+        }
+        if (!mixed)
+        {
+            GatherNeighborhood(cx, cy, cz, out);
+            return;
+        }
+        int size = Size >> lod;
+        int cell = 1 << lod;
+        for (int px = 0; px < size + 2; px++)
+        {
+            for (int py = 0; py < size + 2; py++)
+            {
+                for (int pz = 0; pz < size + 2; pz++)
+                {
+                    int p[3] = {px, py, pz};
+                    int side[3];
+                    int origin[3];
+                    int outside = 0;
+                    int axis = 0;
+                    for (int a = 0; a < 3; a++)
+                    {
+                        side[a] = p[a] == 0 ? 0 : (p[a] > size ? 2 : 1);
+                        origin[a] = ((p[a] - 1 + size) % size) * cell;
+                        if (side[a] != 1)
+                        {
+                            outside++;
+                            axis = a;
+                        }
+                    }
+                    const Chunk* source = around[side[0]][side[1]][side[2]];
+                    if (outside != 1 || !source)
+                    {
+                        out[px][py][pz] = DownsampleCell(source, origin[0], origin[1], origin[2], lod);
+                        continue;
+                    }
+                    int neighborLod = source->lod;
+                    int neighborCell = 1 << neighborLod;
+                    int a1 = (axis + 1) % 3;
+                    int a2 = (axis + 2) % 3;
+                    int at[3];
+                    at[axis] = side[axis] == 0 ? Size - neighborCell : 0;
+                    unsigned char value = 0;
+                    bool covered = true;
+                    for (int u = origin[a1]; u < origin[a1] + cell && covered; u += neighborCell)
+                    {
+                        for (int v = origin[a2]; v < origin[a2] + cell && covered; v += neighborCell)
+                        {
+                            at[a1] = u & ~(neighborCell - 1);
+                            at[a2] = v & ~(neighborCell - 1);
+                            unsigned char block = DownsampleCell(source, at[0], at[1], at[2], neighborLod);
+                            if (block == 0) covered = false;
+                            else if (value == 0) value = block;
+                        }
+                    }
+                    out[px][py][pz] = covered ? value : 0;
+                }
+            }
+        }
+    }
+    // ChunkLight levels for the grid GatherLodNeighborhood fills at lod. A cell of 1 << lod voxels
+    // takes the brightest sun and block level found in it, so the air in a mostly solid cell still
+    // lights the faces next to it. Cells in missing chunks read as full sunlight, like the open
+    // air they are meshed as.
+    void GatherLightNeighborhood(int cx, int cy, int cz, int lod, unsigned char out[Size + 2][Size + 2][Size + 2])
+    {
+        Chunk* around[3][3][3];
+        for (int dx = 0; dx < 3; dx++)
+        {
+            for (int dy = 0; dy < 3; dy++)
+            {
+                for (int dz = 0; dz < 3; dz++)
+                {
+                    around[dx][dy][dz] = GetChunk(cx + dx - 1, cy + dy - 1, cz + dz - 1);
+                }
+            }
+        }
+        int size = Size >> lod;
+        int cell = 1 << lod;
+        for (int px = 0; px < size + 2; px++)
+        {
+            for (int py = 0; py < size + 2; py++)
+            {
+                for (int pz = 0; pz < size + 2; pz++)
+                {
+                    int p[3] = {px, py, pz};
+                    int side[3];
+                    int origin[3];
+                    for (int a = 0; a < 3; a++)
+                    {
+                        side[a] = p[a] == 0 ? 0 : (p[a] > size ? 2 : 1);
+                        origin[a] = ((p[a] - 1 + size) % size) * cell;
+                    }
+                    const Chunk* source = around[side[0]][side[1]][side[2]];
+                    unsigned char value = ChunkMeshBuilder::FullSunlight;
+                    if (source && !source->light.IsUniform(value))
+                    {
+                        int sun = 0;
+                        int block = 0;
+                        for (int i = 0; i < cell; i++)
+                        {
+                            for (int j = 0; j < cell; j++)
+                            {
+                                for (int k = 0; k < cell; k++)
+                                {
+                                    unsigned char level = source->light.Get(origin[0] + i, origin[1] + j, origin[2] + k);
+                                    sun = std::max(sun, ChunkLight::Sun(level));
+                                    block = std::max(block, ChunkLight::Block(level));
+                                }
+                            }
+                        }
+                        value = ChunkLight::Pack(sun, block);
+                    }
+                    out[px][py][pz] = value;
+                }
+            }
+        }
+    }
+};
+// Caches the last chunk it resolved, so runs of lookups that stay inside one chunk
+// (meshing, collision sweeps) skip the hash probe entirely.
+template <int Shift>
+class BasicVoxelAccessor
+{
+private:
+    static constexpr int Mask = ChunkDimensions<Shift>::Mask;
+    BasicChunkManager<Shift>& manager;
+    int cachedX = INT_MIN;
+    int cachedY = INT_MIN;
+    int cachedZ = INT_MIN;
+    BasicChunk<Shift>* cached = nullptr;
+public:
+    explicit BasicVoxelAccessor(BasicChunkManager<Shift>& manager) : manager(manager) {}
+    unsigned char GetBlock(int wx, int wy, int wz)
+    {
+        int cx = wx >> Shift;
+        int cy = wy >> Shift;
+        int cz = wz >> Shift;
+        if (cx != cachedX || cy != cachedY || cz != cachedZ)
+        {
+            cached = manager.GetChunk(cx, cy, cz);
+            cachedX = cx;
+            cachedY = cy;
+            cachedZ = cz;
+        }
+        return cached ? cached->voxels.Get(wx & Mask, wy & Mask, wz & Mask) : 0;
+    }
+    bool IsBlockAt(int wx, int wy, int wz)
+    {
+        return GetBlock(wx, wy, wz) != 0;
+    }
+    // Clips movement of box against solid voxels, y first, then x, then z. Each axis is tested
+    // against the box at its starting position, walking voxel layers outward from the face it
+    // moves toward (within the swept area plus a small margin) and stopping at the first solid one.
+    Float3 SweepBox(const Box3& box, Float3 movement)
+    {
+        const float eps = 0.01f;
+        const float boxMin[3] = {box.min.x, box.min.y, box.min.z};
+        const float boxMax[3] = {box.max.x, box.max.y, box.max.z};
+        float delta[3] = {movement.x, movement.y, movement.z};
+        const int axes[3] = {1, 0, 2};
+        for (int axis : axes)
+        {
+            if (delta[axis] == 0.0f) continue;
+            int a1 = (axis + 1) % 3;
+            int a2 = (axis + 2) % 3;
+            int min1 = (int)floorf(boxMin[a1]);
+            int max1 = (int)ceilf(boxMax[a1]);
+            int min2 = (int)floorf(boxMin[a2]);
+            int max2 = (int)ceilf(boxMax[a2]);
+            bool forward = delta[axis] > 0.0f;
+            int layer = forward ? (int)ceilf(boxMax[axis]) : (int)floorf(boxMin[axis]) - 1;
+            int end = forward ? (int)ceilf(boxMax[axis] + delta[axis] + eps) : (int)floorf(boxMin[axis] + delta[axis] - eps) - 1;
+            int step = forward ? 1 : -1;
+            for (; layer != end; layer += step)
+            {
+                bool blocked = false;
+                for (int u = min1; u < max1 && !blocked; u++)
+                {
+                    for (int v = min2; v < max2 && !blocked; v++)
+                    {
+                        int cell[3];
+                        cell[axis] = layer;
+                        cell[a1] = u;
+                        cell[a2] = v;
+                        blocked = IsBlockAt(cell[0], cell[1], cell[2]);
+                    }
+                }
+                if (!blocked) continue;
+                float limit = forward ? layer - boxMax[axis] : layer + 1.0f - boxMin[axis];
+                if (forward ? limit < delta[axis] : limit > delta[axis]) delta[axis] = limit;
+                break;
+            }
+        }
+        return {delta[0], delta[1], delta[2]};
     }
 };
+using ChunkManager = BasicChunkManager<CHUNK_SHIFT>;
+using VoxelAccessor = BasicVoxelAccessor<CHUNK_SHIFT>;
 
-#endif
\ No newline at end of file
+#endif
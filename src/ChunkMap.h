@@ -0,0 +1,141 @@
+#ifndef CHUNK_MAP_H
+#define CHUNK_MAP_H
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+struct ChunkPos
+{
+    int x, y, z;
+    bool operator==(const ChunkPos& other) const
+    {
+        return x == other.x && y == other.y && z == other.z;
+    }
+};
+// Open-addressing hash map keyed on chunk coordinates packed into 21 bits per axis.
+// Linear probing with backward-shift deletion, so erase never leaves tombstones.
+template <typename T>
+class ChunkMap
+{
+private:
+    static constexpr uint64_t EmptyKey = ~0ull;
+    std::vector<uint64_t> keys;
+    std::vector<std::pair<ChunkPos, T>> entries;
+    size_t count = 0;
+    size_t mask = 0;
+    int shift = 64;
+    static uint64_t PackKey(int x, int y, int z)
+    {
+        const uint64_t bias = 1ull << 20;
+        const uint64_t bits = (1ull << 21) - 1;
+        return ((((uint64_t)x + bias) & bits) << 42) | ((((uint64_t)y + bias) & bits) << 21) | (((uint64_t)z + bias) & bits);
+    }
+    size_t SlotOf(uint64_t key) const
+    {
+        return (size_t)((key * 0x9E3779B97F4A7C15ull) >> shift);
+    }
+    void Rehash(size_t capacity)
+    {
+        std::vector<uint64_t> oldKeys(capacity, EmptyKey);
+        std::vector<std::pair<ChunkPos, T>> oldEntries(capacity);
+        oldKeys.swap(keys);
+        oldEntries.swap(entries);
+        mask = capacity - 1;
+        shift = 64;
+        for (size_t c = capacity; c > 1; c >>= 1) shift--;
+        for (size_t i = 0; i < oldKeys.size(); i++)
+        {
+            if (oldKeys[i] == EmptyKey) continue;
+            size_t slot = SlotOf(oldKeys[i]);
+            while (keys[slot] != EmptyKey) slot = (slot + 1) & mask;
+            keys[slot] = oldKeys[i];
+            entries[slot] = std::move(oldEntries[i]);
+        }
+    }
+public:
+    class Iterator
+    {
+    private:
+        ChunkMap* map;
+        size_t slot;
+        void SkipEmpty()
+        {
+            while (slot < map->keys.size() && map->keys[slot] == EmptyKey) slot++;
+        }
+    public:
+        Iterator(ChunkMap* map, size_t slot) : map(map), slot(slot) { SkipEmpty(); }
+        std::pair<ChunkPos, T>& operator*() const { return map->entries[slot]; }
+        std::pair<ChunkPos, T>* operator->() const { return &map->entries[slot]; }
+        Iterator& operator++()
+        {
+            slot++;
+            SkipEmpty();
+            return *this;
+        }
+        bool operator!=(const Iterator& other) const { return slot != other.slot; }
+    };
+    Iterator begin() { return Iterator(this, 0); }
+    Iterator end() { return Iterator(this, keys.size()); }
+    size_t Size() const { return count; }
+    T* Find(int x, int y, int z)
+    {
+        if (count == 0) return nullptr;
+        uint64_t key = PackKey(x, y, z);
+        for (size_t slot = SlotOf(key);; slot = (slot + 1) & mask)
+        {
+            if (keys[slot] == key) return &entries[slot].second;
+            if (keys[slot] == EmptyKey) return nullptr;
+        }
+    }
+    T& operator[](const ChunkPos& pos)
+    {
+        if ((count + 1) * 2 > keys.size()) Rehash(keys.empty() ? 64 : keys.size() * 2);
+        uint64_t key = PackKey(pos.x, pos.y, pos.z);
+        size_t slot = SlotOf(key);
+        while (keys[slot] != EmptyKey)
+        {
+            if (keys[slot] == key) return entries[slot].second;
+            slot = (slot + 1) & mask;
+        }
+        keys[slot] = key;
+        entries[slot] = {pos, T {}};
+        count++;
+        return entries[slot].second;
+    }
+    bool Erase(const ChunkPos& pos)
+    {
+        if (count == 0) return false;
+        uint64_t key = PackKey(pos.x, pos.y, pos.z);
+        size_t slot = SlotOf(key);
+        while (keys[slot] != key)
+        {
+            if (keys[slot] == EmptyKey) return false;
+            slot = (slot + 1) & mask;
+        }
+        size_t hole = slot;
+        for (size_t next = (hole + 1) & mask; keys[next] != EmptyKey; next = (next + 1) & mask)
+        {
+            size_t home = SlotOf(keys[next]);
+            if (((next - home) & mask) >= ((next - hole) & mask))
+            {
+                keys[hole] = keys[next];
+                entries[hole] = std::move(entries[next]);
+                hole = next;
+            }
+        }
+        keys[hole] = EmptyKey;
+        entries[hole] = {};
+        count--;
+        return true;
+    }
+    void Clear()
+    {
+        keys.assign(keys.size(), EmptyKey);
+        for (auto& entry : entries) entry = {};
+        count = 0;
+    }
+};
+
+#endif
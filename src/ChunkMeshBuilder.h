@@ -3,35 +3,135 @@
 
 #include <vector>
 #include <cstring>
-#include "raylib.h"
-#include "raymath.h"
+#include <cstdint>
+#include <bit>
+#include <type_traits>
+#include "VoxelMath.h"
 
-const int CHUNK_SIZE = 16;
+const int CHUNK_SHIFT = 4;
+const int CHUNK_SIZE = 1 << CHUNK_SHIFT;
+const int CHUNK_MASK = CHUNK_SIZE - 1;
+const int CHUNK_LOD_LEVELS = 3;
+
+// Solid bits of one padded column for chunks too tall for a uint64_t (64 voxels plus padding).
+// Supplies just the operators the mesher uses on its column words.
+struct WideColumn
+{
+    uint64_t low = 0;
+    uint64_t high = 0;
+    constexpr WideColumn(uint64_t value = 0) : low(value) {}
+    constexpr WideColumn(uint64_t low, uint64_t high) : low(low), high(high) {}
+    friend constexpr WideColumn operator&(WideColumn a, WideColumn b) { return {a.low & b.low, a.high & b.high}; }
+    friend constexpr WideColumn operator|(WideColumn a, WideColumn b) { return {a.low | b.low, a.high | b.high}; }
+    friend constexpr WideColumn operator~(WideColumn a) { return {~a.low, ~a.high}; }
+    friend constexpr WideColumn operator<<(WideColumn a, int n)
+    {
+        if (n == 0) return a;
+        if (n >= 64) return {0, a.low << (n - 64)};
+        return {a.low << n, a.high << n | a.low >> (64 - n)};
+    }
+    friend constexpr WideColumn operator>>(WideColumn a, int n)
+    {
+        if (n == 0) return a;
+        if (n >= 64) return {a.high >> (n - 64), 0};
+        return {a.low >> n | a.high << (64 - n), a.high >> n};
+    }
+    WideColumn& operator|=(WideColumn b) { return *this = *this | b; }
+};
+namespace ColumnBits
+{
+    template <typename Column>
+    bool Test(Column column, int bit)
+    {
+        return (column >> bit) & 1;
+    }
+    template <typename Column>
+    bool IsEmpty(Column column)
+    {
+        return column == 0;
+    }
+    // Index of the lowest set bit, which is then cleared.
+    template <typename Column>
+    int PopLowest(Column& column)
+    {
+        int bit = std::countr_zero(column);
+        column &= column - 1;
+        return bit;
+    }
+    inline bool Test(WideColumn column, int bit)
+    {
+        return bit < 64 ? (column.low >> bit) & 1 : (column.high >> (bit - 64)) & 1;
+    }
+    inline bool IsEmpty(WideColumn column)
+    {
+        return (column.low | column.high) == 0;
+    }
+    inline int PopLowest(WideColumn& column)
+    {
+        if (column.low != 0) return PopLowest(column.low);
+        return 64 + PopLowest(column.high);
+    }
+}
+// Compile-time dimensions of a chunk 1 << Shift voxels on a side. The mesher, the world and the
+// renderer are templates on Shift; the CHUNK_* constants are ChunkDimensions<CHUNK_SHIFT>, the
+// size the game is built with.
+template <int Shift>
+struct ChunkDimensions
+{
+    static constexpr int Size = 1 << Shift;
+    static constexpr int Mask = Size - 1;
+    static constexpr int Padded = Size + 2;
+    static constexpr int Volume = Size * Size * Size;
+    // Every face lies between a solid voxel and air, so s solid voxels show at most
+    // min(6s, 6(Volume - s) + 6 Size^2) faces, which peaks at 3 (Volume + Size^2).
+    static constexpr int64_t MaxVertices = 4 * 3 * ((int64_t)Volume + Size * Size);
+    // Indices stay 16-bit for as long as the worst-case mesh can be addressed with them.
+    using Index = std::conditional_t<MaxVertices <= 65536, unsigned short, uint32_t>;
+    // One solid bit per padded voxel along a column.
+    using Column = std::conditional_t<Padded <= 32, uint32_t, std::conditional_t<Padded <= 64, uint64_t, WideColumn>>;
+    // PackedVertex spends 5 bits per coordinate, enough for 0..16.
+    static constexpr bool PackedFits = Size <= 16;
+};
 
 namespace VoxelData
 {
-    static const Vector3 CubeVertices[8] = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}, {0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}};
+    static const Float3 CubeVertices[8] = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}, {0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}};
     static const int FaceVertexIndices[6][4] = {{3, 7, 2, 6}, {1, 5, 0, 4}, {1, 2, 5, 6}, {4, 7, 0, 3}, {5, 6, 4, 7}, {0, 3, 1, 2}};
-    static const Vector2 FaceUVs[4] = {{0.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}};
-    static const Vector3 FaceChecks[6] = {{0, 1, 0}, {0, -1, 0}, {1, 0, 0}, {-1, 0, 0}, {0, 0, 1}, {0, 0, -1}};
-    static const Vector3 FaceNormals[6] = {{0, 1, 0}, {0, -1, 0}, {1, 0, 0}, {-1, 0, 0}, {0, 0, 1}, {0, 0, -1}};
-    static Vector3 CachedAOOffsets[6][4][3];
+    static const Float2 FaceUVs[4] = {{0.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}};
+    static const Float3 FaceChecks[6] = {{0, 1, 0}, {0, -1, 0}, {1, 0, 0}, {-1, 0, 0}, {0, 0, 1}, {0, 0, -1}};
+    static const Float3 FaceNormals[6] = {{0, 1, 0}, {0, -1, 0}, {1, 0, 0}, {-1, 0, 0}, {0, 0, 1}, {0, 0, -1}};
+    static Float3 CachedAOOffsets[6][4][3];
+    // Integer copies of FaceChecks and CachedAOOffsets for the mesher's inner loops.
+    static int FaceSteps[6][3];
+    static int AOSteps[6][4][3][3];
+    static int FaceNormalAxis[6];
+    static int FaceUAxis[6];
+    static int FaceVAxis[6];
     static bool isAOCached = false;
+    static int AxisOfDifference(Float3 a, Float3 b)
+    {
+        if (a.x != b.x) return 0;
+        if (a.y != b.y) return 1;
+        return 2;
+    }
     static void PrecomputeAO()
     {
         if (isAOCached) return;
         for (int f = 0; f < 6; ++f)
         {
+            FaceNormalAxis[f] = AxisOfDifference(FaceChecks[f], {0, 0, 0});
+            FaceUAxis[f] = AxisOfDifference(CubeVertices[FaceVertexIndices[f][0]], CubeVertices[FaceVertexIndices[f][2]]);
+            FaceVAxis[f] = AxisOfDifference(CubeVertices[FaceVertexIndices[f][0]], CubeVertices[FaceVertexIndices[f][1]]);
             for (int v = 0; v < 4; ++v)
             {
-                Vector3 vPosLocal = CubeVertices[FaceVertexIndices[f][v]];
-                Vector3 vDir = {
+                Float3 vPosLocal = CubeVertices[FaceVertexIndices[f][v]];
+                Float3 vDir = {
                     (vPosLocal.x - 0.5f) * 2.0f,
                     (vPosLocal.y - 0.5f) * 2.0f,
                     (vPosLocal.z - 0.5f) * 2.0f
                 };
-                Vector3 s1 = {0, 0, 0};
-                Vector3 s2 = {0, 0, 0};
+                Float3 s1 = {0, 0, 0};
+                Float3 s2 = {0, 0, 0};
                 if (FaceChecks[f].x != 0) 
                 { 
                     s1.y = vDir.y;
@@ -48,107 +148,402 @@ namespace VoxelData
                 CachedAOOffsets[f][v][0] = s1;
                 CachedAOOffsets[f][v][1] = s2;
                 CachedAOOffsets[f][v][2] = {s1.x + s2.x, s1.y + s2.y, s1.z + s2.z};
+                for (int k = 0; k < 3; ++k)
+                {
+                    AOSteps[f][v][k][0] = (int)CachedAOOffsets[f][v][k].x;
+                    AOSteps[f][v][k][1] = (int)CachedAOOffsets[f][v][k].y;
+                    AOSteps[f][v][k][2] = (int)CachedAOOffsets[f][v][k].z;
+                }
             }
+            FaceSteps[f][0] = (int)FaceChecks[f].x;
+            FaceSteps[f][1] = (int)FaceChecks[f].y;
+            FaceSteps[f][2] = (int)FaceChecks[f].z;
         }
         isAOCached = true;
     }
 }
-class ChunkMeshBuilder
+// Greedy merges faces into about a third of Naive's triangles but takes two to three times
+// as long to build, so it pays off when drawing and uploading cost more than meshing.
+enum class MeshingMode
+{
+    Naive,
+    Greedy
+};
+enum class VertexFormat
+{
+    Standard,
+    Packed
+};
+// 6-byte vertex for VertexFormat::Packed, unpacked by resources/shadow_packed.vs.
+// position: x | y << 5 | z << 10 (0..CHUNK_SIZE each)
+// attributes: face | u << 3 | v << 8 | ao << 13 (u, v are 0..CHUNK_SIZE for greedy quads)
+// light: sun | block << 4 (0..15 each)
+// All three stay below 2^16, so they survive the float conversion of a non-integer vertex attribute.
+struct PackedVertex
+{
+    unsigned short position;
+    unsigned short attributes;
+    unsigned short light;
+};
+// 36-byte vertex for VertexFormat::Standard, interleaved exactly as it sits in the vertex buffer.
+// color holds the AO brightness in red and the sun and block light levels, scaled to 0..255, in
+// green and blue; the fragment shaders combine them.
+struct StandardVertex
+{
+    float position[3];
+    float texcoord[2];
+    float normal[3];
+    unsigned char color[4];
+};
+// CPU-side result of meshing one chunk; safe to build on a worker thread, or without any GL
+// context at all, and handed to ChunkMeshUpload on the main thread. Only the vertex array
+// matching format is filled. Index is the builder's ChunkDimensions::Index. Clear keeps the
+// capacity, so a reused instance stops allocating once it has held its largest mesh.
+template <typename Index>
+struct BasicChunkMeshData
+{
+    std::vector<StandardVertex> standard;
+    std::vector<PackedVertex> packed;
+    std::vector<Index> indices;
+    VertexFormat format = VertexFormat::Standard;
+    int vertexCount = 0;
+    void Clear()
+    {
+        standard.clear();
+        packed.clear();
+        indices.clear();
+        vertexCount = 0;
+    }
+    const void* VertexData() const
+    {
+        if (format == VertexFormat::Packed) return packed.data();
+        return standard.data();
+    }
+};
+// Meshes one chunk of ChunkDimensions<Shift>. Each LOD is built by its own instantiation of
+// the inner loops, so the cell count along every axis is a compile-time constant.
+template <int Shift>
+class BasicChunkMeshBuilder
 {
 public:
-    static Mesh GenerateMesh(unsigned char voxels[CHUNK_SIZE + 2][CHUNK_SIZE + 2][CHUNK_SIZE + 2])
+    using Dims = ChunkDimensions<Shift>;
+    using MeshData = BasicChunkMeshData<typename Dims::Index>;
+private:
+    using Column = typename Dims::Column;
+    static constexpr int Padded = Dims::Padded;
+    // The padded grid as one solid bit per voxel: bit z of columns[x][y] is voxels[x][y][z] != 0.
+    // Every face and AO test reads these instead of the voxel bytes. Cells of a face and its AO
+    // neighbors never leave [0, Cells + 1] on any axis, so no bounds checks are needed.
+    struct SolidColumns
     {
-        VoxelData::PrecomputeAO();
-        std::vector<float> vertices;
-        std::vector<float> texcoords;
-        std::vector<float> normals;
-        std::vector<unsigned short> indices;
-        std::vector<unsigned char> colors;
-        int vertexCount = 0;
-        auto getV = [&](int x, int y, int z) -> bool
+        Column columns[Padded][Padded];
+    };
+    template <int Cells>
+    static void BuildSolidColumns(const unsigned char voxels[Padded][Padded][Padded], SolidColumns& solid)
+    {
+        for (int x = 0; x < Cells + 2; x++)
+        {
+            for (int y = 0; y < Cells + 2; y++)
+            {
+                Column bits = 0;
+                for (int z = 0; z < Cells + 2; z++) bits |= Column(voxels[x][y][z] != 0) << z;
+                solid.columns[x][y] = bits;
+            }
+        }
+    }
+    static bool IsSolid(const SolidColumns& solid, int x, int y, int z)
+    {
+        return ColumnBits::Test(solid.columns[x][y], z);
+    }
+    // Bit z is set when the solid voxel at (x, y, z) shows face f, for the whole column at once.
+    // interior masks off the padding.
+    static Column VisibleFaces(const SolidColumns& solid, int x, int y, int f, Column interior)
+    {
+        Column column = solid.columns[x][y];
+        Column cover = 0;
+        switch (f)
+        {
+        case 0: cover = solid.columns[x][y + 1]; break;
+        case 1: cover = solid.columns[x][y - 1]; break;
+        case 2: cover = solid.columns[x + 1][y]; break;
+        case 3: cover = solid.columns[x - 1][y]; break;
+        case 4: cover = column >> 1; break;
+        case 5: cover = column << 1; break;
+        }
+        return column & ~cover & interior;
+    }
+    // The four corner AO levels of a visible face.
+    static void ComputeFaceAO(const SolidColumns& solid, int x, int y, int z, int f, int vertexAO[4])
+    {
+        int nx = x + VoxelData::FaceSteps[f][0];
+        int ny = y + VoxelData::FaceSteps[f][1];
+        int nz = z + VoxelData::FaceSteps[f][2];
+        for (int v = 0; v < 4; v++)
+        {
+            const int (*steps)[3] = VoxelData::AOSteps[f][v];
+            bool side1 = IsSolid(solid, nx + steps[0][0], ny + steps[0][1], nz + steps[0][2]);
+            bool side2 = IsSolid(solid, nx + steps[1][0], ny + steps[1][1], nz + steps[1][2]);
+            bool corner = IsSolid(solid, nx + steps[2][0], ny + steps[2][1], nz + steps[2][2]);
+            vertexAO[v] = (side1 && side2) ? 3 : (int)(side1 + side2 + corner);
+        }
+    }
+    // Smooth light for the four corners of a visible face, as sun | block << 4. Each corner
+    // averages the cell in front of the face with whichever of its three AO neighbors are air;
+    // the diagonal only counts when a side is open, as light cannot squeeze between two solids.
+    // Without a light grid every face is in full sunlight.
+    static void ComputeFaceLight(const SolidColumns& solid, const unsigned char light[Padded][Padded][Padded], int x, int y, int z, int f, unsigned char vertexLight[4])
+    {
+        if (!light)
+        {
+            memset(vertexLight, FullSunlight, 4);
+            return;
+        }
+        int nx = x + VoxelData::FaceSteps[f][0];
+        int ny = y + VoxelData::FaceSteps[f][1];
+        int nz = z + VoxelData::FaceSteps[f][2];
+        unsigned char front = light[nx][ny][nz];
+        for (int v = 0; v < 4; v++)
+        {
+            const int (*steps)[3] = VoxelData::AOSteps[f][v];
+            bool open[3];
+            for (int k = 0; k < 3; k++) open[k] = !IsSolid(solid, nx + steps[k][0], ny + steps[k][1], nz + steps[k][2]);
+            open[2] = open[2] && (open[0] || open[1]);
+            int sun = front & 15;
+            int block = front >> 4;
+            int count = 1;
+            for (int k = 0; k < 3; k++)
             {
-                if (x < 0 || x >= CHUNK_SIZE + 2 || y < 0 || y >= CHUNK_SIZE + 2 || z < 0 || z >= CHUNK_SIZE + 2) return false;
-                return voxels[x][y][z] != 0;
-            };
-        for (int x = 1; x <= CHUNK_SIZE; x++)
+                if (!open[k]) continue;
+                unsigned char cell = light[nx + steps[k][0]][ny + steps[k][1]][nz + steps[k][2]];
+                sun += cell & 15;
+                block += cell >> 4;
+                count++;
+            }
+            vertexLight[v] = (unsigned char)((sun + count / 2) / count | ((block + count / 2) / count) << 4);
+        }
+    }
+    // Emits face f of the cell at padded (x, y, z), stretched to width x height cells along the face's UV axes.
+    // Cells are scale voxels wide, so positions and texture repeats stay in voxel units at every LOD.
+    static void EmitQuad(MeshData& out, int x, int y, int z, int f, int width, int height, const int vertexAO[4], const unsigned char vertexLight[4], int scale)
+    {
+        int uAxis = VoxelData::FaceUAxis[f];
+        int vAxis = VoxelData::FaceVAxis[f];
+        for (int v = 0; v < 4; v++)
         {
-            for (int y = 1; y <= CHUNK_SIZE; y++)
+            Float3 vPos = VoxelData::CubeVertices[VoxelData::FaceVertexIndices[f][v]];
+            float* p = (float*)&vPos;
+            p[uAxis] *= width;
+            p[vAxis] *= height;
+            vPos = {(vPos.x + x - 1) * scale, (vPos.y + y - 1) * scale, (vPos.z + z - 1) * scale};
+            if constexpr (Dims::PackedFits)
             {
-                for (int z = 1; z <= CHUNK_SIZE; z++)
+                if (out.format == VertexFormat::Packed)
                 {
-                    if (voxels[x][y][z] == 0) continue;
+                    int px = (int)vPos.x;
+                    int py = (int)vPos.y;
+                    int pz = (int)vPos.z;
+                    int u = (int)VoxelData::FaceUVs[v].x * width * scale;
+                    int t = (int)VoxelData::FaceUVs[v].y * height * scale;
+                    out.packed.push_back({(unsigned short)(px | py << 5 | pz << 10), (unsigned short)(f | u << 3 | t << 8 | vertexAO[v] << 13), vertexLight[v]});
+                    continue;
+                }
+            }
+            unsigned char brightness = 255 - vertexAO[v] * 50;
+            out.standard.push_back({
+                {vPos.x, vPos.y, vPos.z},
+                {VoxelData::FaceUVs[v].x * width * scale, VoxelData::FaceUVs[v].y * height * scale},
+                {VoxelData::FaceNormals[f].x, VoxelData::FaceNormals[f].y, VoxelData::FaceNormals[f].z},
+                {brightness, (unsigned char)((vertexLight[v] & 15) * 17), (unsigned char)((vertexLight[v] >> 4) * 17), 255}});
+        }
+        int vertexCount = out.vertexCount;
+        if (vertexAO[0] + vertexAO[3] > vertexAO[1] + vertexAO[2])
+        {
+            out.indices.push_back(vertexCount + 0);
+            out.indices.push_back(vertexCount + 1);
+            out.indices.push_back(vertexCount + 2);
+            out.indices.push_back(vertexCount + 2);
+            out.indices.push_back(vertexCount + 1);
+            out.indices.push_back(vertexCount + 3);
+        }
+        else
+        {
+            out.indices.push_back(vertexCount + 0);
+            out.indices.push_back(vertexCount + 1);
+            out.indices.push_back(vertexCount + 3);
+            out.indices.push_back(vertexCount + 0);
+            out.indices.push_back(vertexCount + 3);
+            out.indices.push_back(vertexCount + 2);
+        }
+        out.vertexCount += 4;
+    }
+    // Bits 1..Cells: the interior of a padded column.
+    template <int Cells>
+    static Column Interior()
+    {
+        return ~(~Column(0) << Cells) << 1;
+    }
+    // Quads come out in x, y, z, face order, one per visible face.
+    template <int Cells>
+    static void BuildNaive(const SolidColumns& solid, const unsigned char light[Padded][Padded][Padded], int scale, MeshData& out)
+    {
+        const Column interior = Interior<Cells>();
+        for (int x = 1; x <= Cells; x++)
+        {
+            for (int y = 1; y <= Cells; y++)
+            {
+                Column faces[6];
+                Column any = 0;
+                for (int f = 0; f < 6; f++)
+                {
+                    faces[f] = VisibleFaces(solid, x, y, f, interior);
+                    any |= faces[f];
+                }
+                while (!ColumnBits::IsEmpty(any))
+                {
+                    int z = ColumnBits::PopLowest(any);
                     for (int f = 0; f < 6; f++)
                     {
-                        int nx = x + (int)VoxelData::FaceChecks[f].x;
-                        int ny = y + (int)VoxelData::FaceChecks[f].y;
-                        int nz = z + (int)VoxelData::FaceChecks[f].z;
-                        if (getV(nx, ny, nz)) continue;
-                        int vertexAO[4] {};
-                        for (int v = 0; v < 4; v++)
+                        if (!ColumnBits::Test(faces[f], z)) continue;
+                        int vertexAO[4];
+                        unsigned char vertexLight[4];
+                        ComputeFaceAO(solid, x, y, z, f, vertexAO);
+                        ComputeFaceLight(solid, light, x, y, z, f, vertexLight);
+                        EmitQuad(out, x, y, z, f, 1, 1, vertexAO, vertexLight, scale);
+                    }
+                }
+            }
+        }
+    }
+    // Sweeps each face direction slice by slice and merges visible faces into rectangles.
+    // Two faces merge only when their four AO and light levels are identical, and a run only
+    // grows along an axis neither varies on, so the interpolated shading is unchanged.
+    template <int Cells>
+    static void BuildGreedy(const SolidColumns& solid, const unsigned char light[Padded][Padded][Padded], int scale, MeshData& out)
+    {
+        const Column interior = Interior<Cells>();
+        uint64_t mask[Cells][Cells];
+        for (int f = 0; f < 6; f++)
+        {
+            int dAxis = VoxelData::FaceNormalAxis[f];
+            int uAxis = VoxelData::FaceUAxis[f];
+            int vAxis = VoxelData::FaceVAxis[f];
+            for (int d = 1; d <= Cells; d++)
+            {
+                int pos[3];
+                pos[dAxis] = d;
+                for (int v = 0; v < Cells; v++)
+                {
+                    for (int u = 0; u < Cells; u++)
+                    {
+                        pos[uAxis] = u + 1;
+                        pos[vAxis] = v + 1;
+                        mask[v][u] = 0;
+                        if (!ColumnBits::Test(VisibleFaces(solid, pos[0], pos[1], f, interior), pos[2])) continue;
+                        int vertexAO[4];
+                        unsigned char vertexLight[4];
+                        ComputeFaceAO(solid, pos[0], pos[1], pos[2], f, vertexAO);
+                        ComputeFaceLight(solid, light, pos[0], pos[1], pos[2], f, vertexLight);
+                        uint64_t key = 1;
+                        for (int k = 0; k < 4; k++) key |= (uint64_t)vertexAO[k] << (1 + 2 * k) | (uint64_t)vertexLight[k] << (9 + 8 * k);
+                        mask[v][u] = key;
+                    }
+                }
+                for (int v = 0; v < Cells; v++)
+                {
+                    for (int u = 0; u < Cells;)
+                    {
+                        uint64_t key = mask[v][u];
+                        if (key == 0)
+                        {
+                            u++;
+                            continue;
+                        }
+                        int vertexAO[4];
+                        unsigned char vertexLight[4];
+                        int corners[4];
+                        for (int k = 0; k < 4; k++)
+                        {
+                            vertexAO[k] = (int)(key >> (1 + 2 * k)) & 3;
+                            vertexLight[k] = (unsigned char)(key >> (9 + 8 * k));
+                            corners[k] = vertexAO[k] | vertexLight[k] << 2;
+                        }
+                        bool mergeU = corners[0] == corners[2] && corners[1] == corners[3];
+                        bool mergeV = corners[0] == corners[1] && corners[2] == corners[3];
+                        int width = 1;
+                        if (mergeU)
                         {
-                            Vector3 vPos = VoxelData::CubeVertices[VoxelData::FaceVertexIndices[f][v]];
-                            vertices.push_back(vPos.x + x - 1);
-                            vertices.push_back(vPos.y + y - 1);
-                            vertices.push_back(vPos.z + z - 1);
-                            texcoords.push_back(VoxelData::FaceUVs[v].x);
-                            texcoords.push_back(VoxelData::FaceUVs[v].y);
-                            normals.push_back(VoxelData::FaceNormals[f].x);
-                            normals.push_back(VoxelData::FaceNormals[f].y);
-                            normals.push_back(VoxelData::FaceNormals[f].z);
-                            Vector3 s1 = VoxelData::CachedAOOffsets[f][v][0];
-                            Vector3 s2 = VoxelData::CachedAOOffsets[f][v][1];
-                            Vector3 c = VoxelData::CachedAOOffsets[f][v][2];
-                            bool side1 = getV(nx + (int)s1.x, ny + (int)s1.y, nz + (int)s1.z);
-                            bool side2 = getV(nx + (int)s2.x, ny + (int)s2.y, nz + (int)s2.z);
-                            bool corner = getV(nx + (int)c.x, ny + (int)c.y, nz + (int)c.z);
-                            vertexAO[v] = (side1 && side2) ? 3 : (int)(side1 + side2 + corner);
-                            unsigned char brightness = 255 - vertexAO[v] * 50;
-                            colors.push_back(brightness);
-                            colors.push_back(brightness);
-                            colors.push_back(brightness);
-                            colors.push_back(255);
+                            while (u + width < Cells && mask[v][u + width] == key) width++;
                         }
-                        if (vertexAO[0] + vertexAO[3] > vertexAO[1] + vertexAO[2])
+                        int height = 1;
+                        if (mergeV)
                         {
-                            indices.push_back(vertexCount + 0);
-                            indices.push_back(vertexCount + 1);
-                            indices.push_back(vertexCount + 2);
-                            indices.push_back(vertexCount + 2);
-                            indices.push_back(vertexCount + 1);
-                            indices.push_back(vertexCount + 3);
+                            for (; v + height < Cells; height++)
+                            {
+                                int k = 0;
+                                while (k < width && mask[v + height][u + k] == key) k++;
+                                if (k < width) break;
+                            }
                         }
-                        else
+                        for (int h = 0; h < height; h++)
                         {
-                            indices.push_back(vertexCount + 0);
-                            indices.push_back(vertexCount + 1);
-                            indices.push_back(vertexCount + 3);
-                            indices.push_back(vertexCount + 0);
-                            indices.push_back(vertexCount + 3);
-                            indices.push_back(vertexCount + 2);
+                            for (int w = 0; w < width; w++) mask[v + h][u + w] = 0;
                         }
-                        vertexCount += 4;
+                        pos[uAxis] = u + 1;
+                        pos[vAxis] = v + 1;
+                        EmitQuad(out, pos[0], pos[1], pos[2], f, width, height, vertexAO, vertexLight, scale);
+                        u += width;
                     }
                 }
             }
         }
-        Mesh mesh = {0};
-        if (vertexCount > 0)
+    }
+    // The chunk at lod, built with Cells = Dims::Size >> lod fixed at compile time.
+    template <int Lod>
+    static void BuildAtLod(const unsigned char voxels[Padded][Padded][Padded], const unsigned char light[Padded][Padded][Padded], MeshingMode mode, int lod, MeshData& out)
+    {
+        if constexpr (Lod + 1 < CHUNK_LOD_LEVELS)
         {
-            mesh.vertexCount = vertexCount;
-            mesh.triangleCount = (int)indices.size() / 3;
-            mesh.vertices = (float*)MemAlloc(vertices.size() * sizeof(float));
-            memcpy(mesh.vertices, vertices.data(), vertices.size() * sizeof(float));
-            mesh.texcoords = (float*)MemAlloc(texcoords.size() * sizeof(float));
-            memcpy(mesh.texcoords, texcoords.data(), texcoords.size() * sizeof(float));
-            mesh.normals = (float*)MemAlloc(normals.size() * sizeof(float));
-            memcpy(mesh.normals, normals.data(), normals.size() * sizeof(float));
-            mesh.indices = (unsigned short*)MemAlloc(indices.size() * sizeof(unsigned short));
-            memcpy(mesh.indices, indices.data(), indices.size() * sizeof(unsigned short));
-            mesh.colors = (unsigned char*)MemAlloc(colors.size() * sizeof(unsigned char));
-            memcpy(mesh.colors, colors.data(), colors.size() * sizeof(unsigned char));
-            UploadMesh(&mesh, false);
+            if (lod > Lod)
+            {
+                BuildAtLod<Lod + 1>(voxels, light, mode, lod, out);
+                return;
+            }
         }
-        return mesh;
+        constexpr int Cells = Dims::Size >> Lod;
+        SolidColumns solid;
+        BuildSolidColumns<Cells>(voxels, solid);
+        if (mode == MeshingMode::Greedy) BuildGreedy<Cells>(solid, light, 1 << Lod, out);
+        else BuildNaive<Cells>(solid, light, 1 << Lod, out);
+    }
+public:
+    static constexpr unsigned char FullSunlight = 15;
+    // At lod > 0 only the first (Dims::Size >> lod) + 2 entries per axis are read: a padded grid
+    // of cells that are 1 << lod voxels wide, as filled by ChunkManager::GatherLodNeighborhood.
+    // light is the matching grid of ChunkLight levels from GatherLightNeighborhood, or null for
+    // full sunlight everywhere. Chunks too large for PackedVertex always get Standard vertices.
+    static void BuildMeshData(const unsigned char voxels[Padded][Padded][Padded], const unsigned char light[Padded][Padded][Padded], MeshingMode mode, VertexFormat format, int lod, MeshData& out)
+    {
+        VoxelData::PrecomputeAO();
+        out.Clear();
+        out.format = Dims::PackedFits ? format : VertexFormat::Standard;
+        BuildAtLod<0>(voxels, light, mode, lod, out);
+    }
+    static void BuildMeshData(const unsigned char voxels[Padded][Padded][Padded], MeshingMode mode, VertexFormat format, int lod, MeshData& out)
+    {
+        BuildMeshData(voxels, nullptr, mode, format, lod, out);
+    }
+    static MeshData BuildMeshData(const unsigned char voxels[Padded][Padded][Padded], MeshingMode mode = MeshingMode::Naive, VertexFormat format = VertexFormat::Standard, int lod = 0)
+    {
+        MeshData data;
+        BuildMeshData(voxels, mode, format, lod, data);
+        return data;
+    }
+    static int VertexStride(VertexFormat format)
+    {
+        if (format == VertexFormat::Packed) return sizeof(PackedVertex);
+        return sizeof(StandardVertex);
     }
 };
+using ChunkMeshBuilder = BasicChunkMeshBuilder<CHUNK_SHIFT>;
+using ChunkMeshData = ChunkMeshBuilder::MeshData;
 #endif
@@ -0,0 +1,135 @@
+#ifndef CHUNK_MESH_UPLOAD_H
+#define CHUNK_MESH_UPLOAD_H
+
+#include <vector>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include "raylib.h"
+#include "rlgl.h"
+#include "ChunkMeshBuilder.h"
+
+// What a chunk's GPU mesh needs beyond raylib's Mesh: the layout and size of its buffers, and
+// the position-only VAO used by depth passes.
+struct ChunkGpuBuffers
+{
+    VertexFormat format = VertexFormat::Standard;
+    unsigned int depthVao = 0;
+    size_t vertexCapacity = 0;
+    size_t indexCapacity = 0;
+};
+// rlDrawVertexArrayElements only draws 16-bit indices. glDrawElements is core since OpenGL 1.1
+// and exported by every platform's GL library, so it is declared here rather than pulling a GL
+// loader into the build for chunk sizes whose meshes need 32-bit indices.
+#if defined(_WIN32)
+#define CHUNK_GL_APIENTRY __stdcall
+#else
+#define CHUNK_GL_APIENTRY
+#endif
+extern "C" void CHUNK_GL_APIENTRY glDrawElements(unsigned int mode, int count, unsigned int type, const void* indices);
+// The GL side of chunk meshes: writes ChunkMeshData into a chunk's vertex and index buffers.
+// Everything here needs the window's context, so it only runs on the main thread.
+class ChunkMeshUpload
+{
+private:
+    static constexpr int VboSlots = 16;
+    // rlgl names GL's byte and float types but not these two.
+    static constexpr unsigned int GlUnsignedShort = 0x1403;
+    static constexpr unsigned int GlUnsignedInt = 0x1405;
+    static size_t WithHeadroom(size_t bytes)
+    {
+        return std::max<size_t>(bytes + bytes / 2, 4096);
+    }
+    static void DestroyBuffers(Mesh& mesh, ChunkGpuBuffers& gpu)
+    {
+        if (mesh.vaoId == 0) return;
+        rlUnloadVertexArray(gpu.depthVao);
+        rlUnloadVertexArray(mesh.vaoId);
+        rlUnloadVertexBuffer(mesh.vboId[0]);
+        rlUnloadVertexBuffer(mesh.vboId[1]);
+        mesh.vaoId = 0;
+        mesh.vboId[0] = 0;
+        mesh.vboId[1] = 0;
+        gpu = ChunkGpuBuffers();
+    }
+    // Builds both VAOs by hand over one interleaved vertex buffer (vboId[0]) and one index
+    // buffer (vboId[1]); raylib's UploadMesh only knows separate float arrays. The index buffer
+    // is bound while each VAO is active, so drawing only needs the VAO id.
+    static void CreateBuffers(Mesh& mesh, ChunkGpuBuffers& gpu, VertexFormat format, size_t vertexBytes, size_t indexBytes)
+    {
+        gpu.format = format;
+        gpu.vertexCapacity = WithHeadroom(vertexBytes);
+        gpu.indexCapacity = WithHeadroom(indexBytes);
+        if (!mesh.vboId) mesh.vboId = (unsigned int*)MemAlloc(VboSlots * sizeof(unsigned int));
+        mesh.vaoId = rlLoadVertexArray();
+        rlEnableVertexArray(mesh.vaoId);
+        mesh.vboId[0] = rlLoadVertexBuffer(nullptr, (int)gpu.vertexCapacity, true);
+        SetVertexAttributes(format, false);
+        mesh.vboId[1] = rlLoadVertexBufferElement(nullptr, (int)gpu.indexCapacity, true);
+        rlDisableVertexArray();
+        gpu.depthVao = rlLoadVertexArray();
+        rlEnableVertexArray(gpu.depthVao);
+        rlEnableVertexBuffer(mesh.vboId[0]);
+        SetVertexAttributes(format, true);
+        rlEnableVertexBufferElement(mesh.vboId[1]);
+        rlDisableVertexArray();
+    }
+public:
+    // Attribute pointers into the bound vertex buffer, for the active VAO. positionOnly is the
+    // layout the depth shaders read.
+    static void SetVertexAttributes(VertexFormat format, bool positionOnly)
+    {
+        int stride = ChunkMeshBuilder::VertexStride(format);
+        if (format == VertexFormat::Packed)
+        {
+            rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION, positionOnly ? 1 : 3, GlUnsignedShort, false, stride, 0);
+            rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION);
+            return;
+        }
+        rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION, 3, RL_FLOAT, false, stride, (int)offsetof(StandardVertex, position));
+        rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION);
+        if (positionOnly) return;
+        rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD, 2, RL_FLOAT, false, stride, (int)offsetof(StandardVertex, texcoord));
+        rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_NORMAL, 3, RL_FLOAT, false, stride, (int)offsetof(StandardVertex, normal));
+        rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR, 4, RL_UNSIGNED_BYTE, true, stride, (int)offsetof(StandardVertex, color));
+        rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD);
+        rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_NORMAL);
+        rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR);
+    }
+    // Overwrites the mesh's buffers in place. They are only recreated, with headroom, when data
+    // outgrows them or switches vertex format. Returns the bytes written.
+    template <typename Index>
+    static size_t UploadMeshData(Mesh& mesh, ChunkGpuBuffers& gpu, const BasicChunkMeshData<Index>& data)
+    {
+        size_t vertexBytes = (size_t)data.vertexCount * ChunkMeshBuilder::VertexStride(data.format);
+        size_t indexBytes = data.indices.size() * sizeof(Index);
+        mesh.vertexCount = data.vertexCount;
+        mesh.triangleCount = (int)data.indices.size() / 3;
+        if (vertexBytes == 0) return 0;
+        if (mesh.vaoId == 0 || gpu.format != data.format || vertexBytes > gpu.vertexCapacity || indexBytes > gpu.indexCapacity)
+        {
+            DestroyBuffers(mesh, gpu);
+            CreateBuffers(mesh, gpu, data.format, vertexBytes, indexBytes);
+        }
+        rlUpdateVertexBuffer(mesh.vboId[0], data.VertexData(), (int)vertexBytes, 0);
+        rlEnableVertexArray(mesh.vaoId);
+        rlUpdateVertexBufferElements(mesh.vboId[1], data.indices.data(), (int)indexBytes, 0);
+        rlDisableVertexArray();
+        return vertexBytes + indexBytes;
+    }
+    // Draws count indices of the bound VAO, whose mesh was uploaded with Index.
+    template <typename Index>
+    static void DrawElements(int count)
+    {
+        if constexpr (sizeof(Index) == sizeof(unsigned short)) rlDrawVertexArrayElements(0, count, 0);
+        else glDrawElements(RL_TRIANGLES, count, GlUnsignedInt, nullptr);
+    }
+    // The depth VAO shares the mesh's buffers, so this runs before the owning model is unloaded.
+    static void UnloadDepthVertexArray(ChunkGpuBuffers& gpu)
+    {
+        if (gpu.depthVao != 0) rlUnloadVertexArray(gpu.depthVao);
+        gpu = ChunkGpuBuffers();
+    }
+};
+
+#endif
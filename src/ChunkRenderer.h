@@ -0,0 +1,319 @@
+#ifndef CHUNK_RENDERER_H
+#define CHUNK_RENDERER_H
+
+#include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include <vector>
+#include <string>
+#include "ChunkManager.h"
+#include "ChunkMeshUpload.h"
+#include "ChunkBatches.h"
+
+inline Float3 ToFloat3(Vector3 v)
+{
+    return {v.x, v.y, v.z};
+}
+inline Vector3 ToVector3(Float3 v)
+{
+    return {v.x, v.y, v.z};
+}
+// viewProjection is MatrixMultiply(view, projection), i.e. the matrix raylib uploads as mvp for
+// an identity model; the bounds narrow the side planes as in Frustum::FromRows.
+inline Frustum FrustumFromMatrix(const Matrix& viewProjection, float minX = -1.0f, float minY = -1.0f, float maxX = 1.0f, float maxY = 1.0f)
+{
+    const Matrix& m = viewProjection;
+    const Float4 rows[4] = {{m.m0, m.m4, m.m8, m.m12}, {m.m1, m.m5, m.m9, m.m13}, {m.m2, m.m6, m.m10, m.m14}, {m.m3, m.m7, m.m11, m.m15}};
+    return Frustum::FromRows(rows, minX, minY, maxX, maxY);
+}
+// The GPU side of a BasicChunkManager's chunks: uploads the meshes it finishes, frees them when
+// their chunks unload, and draws them. Everything here needs the window's GL context, so call
+// Unload before CloseWindow.
+template <int Shift>
+class BasicChunkRenderer
+{
+private:
+    using World = BasicChunkManager<Shift>;
+    using ChunkMeshData = typename World::ChunkMeshData;
+    using Index = typename ChunkDimensions<Shift>::Index;
+    struct ChunkModel
+    {
+        Model model = {0};
+        ChunkGpuBuffers gpu;
+        // Triangles held for this chunk in ChunkBatches, when batched draws are on.
+        int batchedTriangles = 0;
+        // A remesh to nothing keeps the model and its buffers for the next edit, so this, not
+        // model.meshCount, says whether there is anything to draw.
+        int TriangleCount() const
+        {
+            return (model.meshCount > 0 ? model.meshes[0].triangleCount : 0) + batchedTriangles;
+        }
+    };
+    World& world;
+    Texture2D worldTexture = {0};
+    ChunkMap<ChunkModel> models;
+    BasicChunkBatches<Shift> batches;
+    bool batchedDraws = true;
+    std::vector<Box3> changedRegions;
+    std::vector<ChunkPos> releasedMeshes;
+    // Loaded on the first upload, so a renderer that never uploads never needs a GL context.
+    void LoadResources()
+    {
+        if (worldTexture.id != 0) return;
+        worldTexture = LoadTexture("resources/my_texture.png");
+        SetTextureWrap(worldTexture, TEXTURE_WRAP_REPEAT);
+    }
+    // Anything that adds or removes triangles records the chunk's box, so cached passes can redraw it.
+    void ReleaseChunkModel(ChunkModel& chunk)
+    {
+        if (chunk.model.meshCount == 0) return;
+        ChunkMeshUpload::UnloadDepthVertexArray(chunk.gpu);
+        UnloadModel(chunk.model);
+        chunk.model = {0};
+    }
+    void ReleaseChunkMesh(const ChunkPos& pos, ChunkModel& chunk)
+    {
+        if (chunk.TriangleCount() > 0) changedRegions.push_back(ChunkBounds<Shift>(pos));
+        if (chunk.batchedTriangles > 0) batches.Remove(pos);
+        chunk.batchedTriangles = 0;
+        ReleaseChunkModel(chunk);
+    }
+    // Frees the chunk's batch range, but keeps an unbatched model's buffers for the next mesh.
+    void ClearChunkMesh(const ChunkPos& pos, ChunkModel& chunk)
+    {
+        if (chunk.TriangleCount() == 0) return;
+        changedRegions.push_back(ChunkBounds<Shift>(pos));
+        if (chunk.batchedTriangles > 0) batches.Remove(pos);
+        chunk.batchedTriangles = 0;
+        if (chunk.model.meshCount == 0) return;
+        chunk.model.meshes[0].vertexCount = 0;
+        chunk.model.meshes[0].triangleCount = 0;
+    }
+    // Runs before every batch of uploads, so a chunk that unloaded and came back drops its old
+    // mesh before the new one arrives.
+    void ReleaseUnloadedChunks()
+    {
+        world.TakeReleasedMeshes(releasedMeshes);
+        for (const ChunkPos& pos : releasedMeshes)
+        {
+            ChunkModel* chunk = models.Find(pos.x, pos.y, pos.z);
+            if (!chunk) continue;
+            ReleaseChunkMesh(pos, *chunk);
+            models.Erase(pos);
+        }
+        releasedMeshes.clear();
+    }
+    // Returns the bytes uploaded; empty meshes upload nothing. With batched draws the mesh goes
+    // into the chunk's batch range when it fits one. Otherwise the chunk's model is created on
+    // its first non-empty mesh and then updated in place for as long as it is loaded. Either
+    // way, storage left from the other mode is freed here, so a switch takes effect chunk by chunk.
+    size_t UploadChunkMesh(const ChunkPos& pos, const ChunkMeshData& data)
+    {
+        ChunkModel& chunk = models[pos];
+        if (data.vertexCount == 0)
+        {
+            ClearChunkMesh(pos, chunk);
+            return 0;
+        }
+        LoadResources();
+        if (batchedDraws && batches.Fits(data))
+        {
+            ReleaseChunkModel(chunk);
+            changedRegions.push_back(ChunkBounds<Shift>(pos));
+            chunk.batchedTriangles = (int)data.indices.size() / 3;
+            return batches.Upload(pos, data);
+        }
+        if (chunk.batchedTriangles > 0) ClearChunkMesh(pos, chunk);
+        if (chunk.model.meshCount == 0)
+        {
+            chunk.model = LoadModelFromMesh(Mesh {0});
+            chunk.model.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = worldTexture;
+        }
+        changedRegions.push_back(ChunkBounds<Shift>(pos));
+        return ChunkMeshUpload::UploadMeshData(chunk.model.meshes[0], chunk.gpu, data);
+    }
+    auto Uploader()
+    {
+        return [this](const ChunkPos& pos, const ChunkMeshData& data) { return UploadChunkMesh(pos, data); };
+    }
+public:
+    explicit BasicChunkRenderer(World& world) : world(world) {}
+    // LoadShader for the chunk shaders: CHUNK_SIZE and BATCH_SHIFT, which they use to place
+    // batched vertices, are defined right after the vertex shader's #version line.
+    static Shader LoadChunkShader(const char* vsFileName, const char* fsFileName)
+    {
+        char* vsText = LoadFileText(vsFileName);
+        char* fsText = LoadFileText(fsFileName);
+        std::string vs = vsText ? vsText : "";
+        vs.insert(vs.find('\n') + 1, TextFormat("#define CHUNK_SIZE %d.0\n#define BATCH_SHIFT %du\n", ChunkDimensions<Shift>::Size, BasicChunkBatches<Shift>::BatchShift));
+        Shader shader = LoadShaderFromMemory(vs.c_str(), fsText);
+        UnloadFileText(vsText);
+        UnloadFileText(fsText);
+        return shader;
+    }
+    // Frees every model, batch and the texture; the renderer can upload again afterwards.
+    void Unload()
+    {
+        for (auto& [coords, c] : models) ReleaseChunkModel(c);
+        models.Clear();
+        batches.Clear();
+        if (worldTexture.id != 0) UnloadTexture(worldTexture);
+        worldTexture = {0};
+    }
+    // Uploads the world's finished meshes until the budget is spent; see ChunkManager::ProcessMeshes.
+    UploadStats ProcessUploads(double budgetMilliseconds)
+    {
+        ReleaseUnloadedChunks();
+        return world.ProcessMeshes(budgetMilliseconds, Uploader());
+    }
+    void FinishPendingMeshes()
+    {
+        ReleaseUnloadedChunks();
+        world.FinishPendingMeshes(Uploader());
+    }
+    // Rebuilds and uploads the chunks edited since the last call; see ChunkManager::RemeshDirtyChunks.
+    UploadStats RemeshDirtyChunks()
+    {
+        ReleaseUnloadedChunks();
+        return world.RemeshDirtyChunks(Uploader());
+    }
+    bool GetBatchedDraws() const
+    {
+        return batchedDraws;
+    }
+    void SetBatchedDraws(bool enabled)
+    {
+        if (enabled == batchedDraws) return;
+        batchedDraws = enabled;
+        world.RebuildAllMeshes();
+    }
+    // The world's meshing stats plus what is on the GPU.
+    MeshStats GetMeshStats()
+    {
+        MeshStats stats = world.GetMeshStats();
+        stats.gpuBytes = batches.GpuBytes();
+        for (auto const& [coords, c] : models)
+        {
+            stats.gpuBytes += c.gpu.vertexCapacity + c.gpu.indexCapacity;
+            if (c.TriangleCount() == 0) continue;
+            // Quads throughout: 4 vertices per 2 triangles.
+            stats.vertexCount += c.TriangleCount() * 2;
+            stats.triangleCount += c.TriangleCount();
+            typename World::Chunk* chunk = world.GetChunk(coords.x, coords.y, coords.z);
+            if (chunk) stats.lodChunks[chunk->lod]++;
+        }
+        return stats;
+    }
+    // Chunks without triangles are skipped outright; the rest are tested against the pass frustum
+    // and the world's last UpdateOcclusion. Like DrawDepth, each chunk and page is drawn with the
+    // shader for the format its mesh was built with. The texture and material uniforms are set
+    // once per shader for the whole pass; only the matrices change per chunk or batch. Call
+    // between BeginMode3D and EndMode3D.
+    DrawStats DrawWorld(const Frustum& frustum, Shader standardShader, Shader packedShader)
+    {
+        DrawStats stats;
+        rlDrawRenderBatchActive();
+        Matrix viewProjection = MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
+        float diffuse[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+        int textureSlot = 0;
+        const Shader shaders[2] = {standardShader, packedShader};
+        for (const Shader& shader : shaders)
+        {
+            rlEnableShader(shader.id);
+            rlSetUniform(shader.locs[SHADER_LOC_MAP_DIFFUSE], &textureSlot, RL_SHADER_UNIFORM_INT, 1);
+            rlSetUniform(shader.locs[SHADER_LOC_COLOR_DIFFUSE], diffuse, RL_SHADER_UNIFORM_VEC4, 1);
+        }
+        rlActiveTextureSlot(0);
+        rlEnableTexture(worldTexture.id);
+        unsigned int boundShader = 0;
+        for (auto const& [coords, c] : models)
+        {
+            if (c.TriangleCount() == 0)
+            {
+                stats.emptyChunks++;
+                continue;
+            }
+            if (c.batchedTriangles > 0) continue;
+            Box3 bounds = ChunkBounds<Shift>(coords);
+            if (!frustum.IntersectsBox(bounds))
+            {
+                stats.culledChunks++;
+                continue;
+            }
+            if (world.IsOccluded(coords))
+            {
+                stats.occludedChunks++;
+                continue;
+            }
+            stats.visibleChunks++;
+            stats.drawCalls++;
+            stats.triangles += c.model.meshes[0].triangleCount;
+            const Shader& shader = shaders[(int)c.gpu.format];
+            if (shader.id != boundShader)
+            {
+                rlEnableShader(shader.id);
+                boundShader = shader.id;
+            }
+            Matrix model = MatrixTranslate(bounds.min.x, bounds.min.y, bounds.min.z);
+            rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_MVP], MatrixMultiply(model, viewProjection));
+            rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_MODEL], model);
+            rlEnableVertexArray(c.model.meshes[0].vaoId);
+            ChunkMeshUpload::DrawElements<Index>(c.model.meshes[0].triangleCount * 3);
+        }
+        batches.Draw(frustum, viewProjection, shaders, false, stats, [this](const ChunkPos& pos) { return world.IsOccluded(pos); });
+        rlDisableVertexArray();
+        rlDisableTexture();
+        rlDisableShader();
+        return stats;
+    }
+    // Position-only draw for depth passes. Each chunk picks the depth shader matching the
+    // format its mesh was built with, so a format switch in progress still renders correctly.
+    // Occlusion is not applied: the shadow map is drawn from the light and cached across frames.
+    DrawStats DrawDepth(const Frustum& frustum, Matrix viewProjection, Shader standardShader, Shader packedShader)
+    {
+        DrawStats stats;
+        unsigned int boundShader = 0;
+        for (auto const& [coords, c] : models)
+        {
+            if (c.TriangleCount() == 0)
+            {
+                stats.emptyChunks++;
+                continue;
+            }
+            if (c.batchedTriangles > 0) continue;
+            Box3 bounds = ChunkBounds<Shift>(coords);
+            if (!frustum.IntersectsBox(bounds))
+            {
+                stats.culledChunks++;
+                continue;
+            }
+            stats.visibleChunks++;
+            const Shader& shader = c.gpu.format == VertexFormat::Packed ? packedShader : standardShader;
+            if (shader.id != boundShader)
+            {
+                rlEnableShader(shader.id);
+                boundShader = shader.id;
+            }
+            Matrix mvp = MatrixMultiply(MatrixTranslate(bounds.min.x, bounds.min.y, bounds.min.z), viewProjection);
+            rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_MVP], mvp);
+            rlEnableVertexArray(c.gpu.depthVao);
+            stats.drawCalls++;
+            stats.triangles += c.model.meshes[0].triangleCount;
+            ChunkMeshUpload::DrawElements<Index>(c.model.meshes[0].triangleCount * 3);
+        }
+        const Shader shaders[2] = {standardShader, packedShader};
+        batches.Draw(frustum, viewProjection, shaders, true, stats, [](const ChunkPos&) { return false; });
+        rlDisableVertexArray();
+        rlDisableShader();
+        return stats;
+    }
+    // Boxes of chunks whose triangles changed since the last call, appended to out.
+    void TakeChangedRegions(std::vector<Box3>& out)
+    {
+        out.insert(out.end(), changedRegions.begin(), changedRegions.end());
+        changedRegions.clear();
+    }
+};
+using ChunkRenderer = BasicChunkRenderer<CHUNK_SHIFT>;
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef CHUNK_VISIBILITY_H
+#define CHUNK_VISIBILITY_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "ChunkMeshBuilder.h"
+
+// Which faces of a chunk can see each other through its air: bit b of connections[a] is set
+// when some path of air cells inside the chunk touches both face a and face b. Faces are
+// numbered +x, -x, +y, -y, +z, -z, so face ^ 1 is the opposite face. A chunk nobody has
+// measured yet is treated as fully open.
+struct ChunkVisibility
+{
+    static constexpr int FaceCount = 6;
+    // Step to the neighbor across each face; every face walk over voxels or chunks uses this order.
+    static constexpr int FaceOffsets[FaceCount][3] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+    static constexpr unsigned char AllFaces = (1 << FaceCount) - 1;
+    unsigned char connections[FaceCount] = {AllFaces, AllFaces, AllFaces, AllFaces, AllFaces, AllFaces};
+    bool Connects(int from, int to) const
+    {
+        return (connections[from] >> to) & 1;
+    }
+    static ChunkVisibility Open()
+    {
+        return ChunkVisibility();
+    }
+    static ChunkVisibility Closed()
+    {
+        ChunkVisibility visibility;
+        memset(visibility.connections, 0, sizeof(visibility.connections));
+        return visibility;
+    }
+    // Flood fills the air of the size^3 cells at [1, size] of a padded neighborhood, as gathered
+    // for meshing at any chunk size; size is a power of two. Only air on the border can reach a
+    // face, so fills start there and pockets sealed inside the chunk are never visited.
+    template <int Padded>
+    static ChunkVisibility Compute(const unsigned char (&voxels)[Padded][Padded][Padded], int size)
+    {
+        constexpr int Volume = (Padded - 2) * (Padded - 2) * (Padded - 2);
+        ChunkVisibility visibility = Closed();
+        uint64_t visited[Volume / 64] = {};
+        // 32-bit cell indices, up to 1 MB of them for a 64^3 chunk, so the fill stack is kept per
+        // thread rather than on the call stack of a worker.
+        static thread_local std::vector<uint32_t> stack(Volume);
+        int shift = 0;
+        while ((1 << shift) < size) shift++;
+        const int last = size - 1;
+        auto isOpen = [&](int i)
+        {
+            int x = i >> (2 * shift);
+            int y = (i >> shift) & last;
+            int z = i & last;
+            return voxels[x + 1][y + 1][z + 1] == 0 && !((visited[i >> 6] >> (i & 63)) & 1);
+        };
+        for (int seed = 0; seed < size * size * size; seed++)
+        {
+            int sx = seed >> (2 * shift);
+            int sy = (seed >> shift) & last;
+            int sz = seed & last;
+            bool border = sx == 0 || sx == last || sy == 0 || sy == last || sz == 0 || sz == last;
+            if (!border || !isOpen(seed)) continue;
+            unsigned char faces = 0;
+            int top = 0;
+            stack[top++] = (uint32_t)seed;
+            visited[seed >> 6] |= 1ull << (seed & 63);
+            while (top > 0)
+            {
+                int i = stack[--top];
+                int x = i >> (2 * shift);
+                int y = (i >> shift) & last;
+                int z = i & last;
+                if (x == last) faces |= 1 << 0;
+                if (x == 0) faces |= 1 << 1;
+                if (y == last) faces |= 1 << 2;
+                if (y == 0) faces |= 1 << 3;
+                if (z == last) faces |= 1 << 4;
+                if (z == 0) faces |= 1 << 5;
+                const int neighbors[6] = {
+                    x < last ? i + size * size : -1, x > 0 ? i - size * size : -1,
+                    y < last ? i + size : -1, y > 0 ? i - size : -1,
+                    z < last ? i + 1 : -1, z > 0 ? i - 1 : -1};
+                for (int n : neighbors)
+                {
+                    if (n < 0 || !isOpen(n)) continue;
+                    visited[n >> 6] |= 1ull << (n & 63);
+                    stack[top++] = (uint32_t)n;
+                }
+            }
+            for (int face = 0; face < FaceCount; face++)
+            {
+                if ((faces >> face) & 1) visibility.connections[face] |= faces;
+            }
+        }
+        return visibility;
+    }
+};
+
+#endif
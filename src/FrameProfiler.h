@@ -0,0 +1,196 @@
+#ifndef FRAME_PROFILER_H
+#define FRAME_PROFILER_H
+
+#include "raylib.h"
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+
+// Stages of the main loop, in the order they run. Times are CPU wall time on the main thread;
+// Present includes the swap and the frame-rate limiter's wait.
+enum class ProfilePhase
+{
+    Uploads,
+    Systems,
+    Streaming,
+    Remesh,
+    Shadow,
+    MainPass,
+    Hud,
+    Present,
+    Count
+};
+enum class ProfileCounter
+{
+    DrawCalls,
+    Triangles,
+    ChunksMeshed,
+    BytesUploaded,
+    Count
+};
+// Per-frame phase timers and counters, kept for the last HistorySize frames. The overlay shows
+// the latest frame, the averages and a stacked frame-time graph; while recording, every frame
+// is also appended to a CSV file.
+class FrameProfiler
+{
+public:
+    static constexpr int PhaseCount = (int)ProfilePhase::Count;
+    static constexpr int CounterCount = (int)ProfileCounter::Count;
+    static constexpr int HistorySize = 240;
+    class Scope
+    {
+    private:
+        FrameProfiler& profiler;
+        ProfilePhase phase;
+        std::chrono::steady_clock::time_point start;
+    public:
+        Scope(FrameProfiler& profiler, ProfilePhase phase) : profiler(profiler), phase(phase), start(std::chrono::steady_clock::now()) {}
+        ~Scope()
+        {
+            profiler.AddTime(phase, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+private:
+    struct FrameRecord
+    {
+        double frameMilliseconds = 0.0;
+        double phaseMilliseconds[PhaseCount] = {};
+        long long counters[CounterCount] = {};
+    };
+    static constexpr const char* PhaseNames[PhaseCount] = {"Uploads", "Systems", "Streaming", "Remesh", "Shadow", "Main pass", "HUD", "Present"};
+    static constexpr const char* PhaseColumns[PhaseCount] = {"uploads_ms", "systems_ms", "streaming_ms", "remesh_ms", "shadow_ms", "main_pass_ms", "hud_ms", "present_ms"};
+    static constexpr const char* CounterNames[CounterCount] = {"Draw calls", "Triangles", "Chunks meshed", "Bytes uploaded"};
+    static constexpr const char* CounterColumns[CounterCount] = {"draw_calls", "triangles", "chunks_meshed", "bytes_uploaded"};
+    FrameRecord history[HistorySize];
+    FrameRecord current;
+    long long frameNumber = 0;
+    std::chrono::steady_clock::time_point frameStart;
+    bool overlayVisible = false;
+    FILE* csv = nullptr;
+    static Color PhaseColor(int phase)
+    {
+        const Color colors[PhaseCount] = {MAGENTA, ORANGE, YELLOW, PURPLE, SKYBLUE, GREEN, LIGHTGRAY, DARKGRAY};
+        return colors[phase];
+    }
+    void WriteCsvRow(const FrameRecord& record)
+    {
+        fprintf(csv, "%lld,%.4f", frameNumber, record.frameMilliseconds);
+        for (int p = 0; p < PhaseCount; p++) fprintf(csv, ",%.4f", record.phaseMilliseconds[p]);
+        for (int c = 0; c < CounterCount; c++) fprintf(csv, ",%lld", record.counters[c]);
+        fprintf(csv, "\n");
+    }
+public:
+    ~FrameProfiler()
+    {
+        StopCsv();
+    }
+    void BeginFrame()
+    {
+        current = FrameRecord();
+        frameStart = std::chrono::steady_clock::now();
+    }
+    void EndFrame()
+    {
+        current.frameMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+        history[frameNumber % HistorySize] = current;
+        if (csv) WriteCsvRow(current);
+        frameNumber++;
+    }
+    Scope Measure(ProfilePhase phase)
+    {
+        return Scope(*this, phase);
+    }
+    void AddTime(ProfilePhase phase, double milliseconds)
+    {
+        current.phaseMilliseconds[(int)phase] += milliseconds;
+    }
+    void Count(ProfileCounter counter, long long amount)
+    {
+        current.counters[(int)counter] += amount;
+    }
+    void ToggleOverlay()
+    {
+        overlayVisible = !overlayVisible;
+    }
+    bool IsRecording() const
+    {
+        return csv != nullptr;
+    }
+    // Starts a new file with a header row; frames are appended until StopCsv.
+    bool StartCsv(const char* path)
+    {
+        StopCsv();
+        csv = fopen(path, "w");
+        if (!csv)
+        {
+            TraceLog(LOG_WARNING, "PROFILER: Failed to open %s", path);
+            return false;
+        }
+        fprintf(csv, "frame,frame_ms");
+        for (int p = 0; p < PhaseCount; p++) fprintf(csv, ",%s", PhaseColumns[p]);
+        for (int c = 0; c < CounterCount; c++) fprintf(csv, ",%s", CounterColumns[c]);
+        fprintf(csv, "\n");
+        return true;
+    }
+    void StopCsv()
+    {
+        if (!csv) return;
+        fclose(csv);
+        csv = nullptr;
+    }
+    // Latest frame and the average over the history, then one stacked bar per frame
+    // (oldest on the left) scaled so the top of the graph is 33.3 ms.
+    void DrawOverlay(int x, int y)
+    {
+        if (!overlayVisible) return;
+        const int width = HistorySize * 2;
+        const int graphHeight = 100;
+        const int lineHeight = 18;
+        int frames = (int)std::min<long long>(frameNumber, HistorySize);
+        if (frames == 0) return;
+        FrameRecord average;
+        for (int i = 0; i < frames; i++)
+        {
+            average.frameMilliseconds += history[i].frameMilliseconds / frames;
+            for (int p = 0; p < PhaseCount; p++) average.phaseMilliseconds[p] += history[i].phaseMilliseconds[p] / frames;
+        }
+        const FrameRecord& last = history[(frameNumber - 1) % HistorySize];
+        int height = (PhaseCount + CounterCount + 2) * lineHeight + graphHeight + 20;
+        DrawRectangle(x, y, width + 20, height, ColorAlpha(BLACK, 0.6f));
+        int textY = y + 8;
+        DrawText(TextFormat("Frame %.2f ms (avg %.2f)%s", last.frameMilliseconds, average.frameMilliseconds, csv ? "  REC" : ""), x + 10, textY, 16, WHITE);
+        textY += lineHeight;
+        for (int p = 0; p < PhaseCount; p++)
+        {
+            DrawRectangle(x + 10, textY + 4, 8, 8, PhaseColor(p));
+            DrawText(TextFormat("%-10s %6.2f ms  avg %6.2f", PhaseNames[p], last.phaseMilliseconds[p], average.phaseMilliseconds[p]), x + 24, textY, 16, WHITE);
+            textY += lineHeight;
+        }
+        for (int c = 0; c < CounterCount; c++)
+        {
+            DrawText(TextFormat("%-14s %lld", CounterNames[c], last.counters[c]), x + 10, textY, 16, WHITE);
+            textY += lineHeight;
+        }
+        float graphTop = (float)(textY + lineHeight);
+        float graphBottom = graphTop + graphHeight;
+        const float scale = graphHeight / 33.3f;
+        for (int i = 0; i < frames; i++)
+        {
+            const FrameRecord& record = history[(frameNumber - frames + i) % HistorySize];
+            float barX = (float)(x + 10 + (HistorySize - frames + i) * 2);
+            float segmentBottom = graphBottom;
+            for (int p = 0; p < PhaseCount && segmentBottom > graphTop; p++)
+            {
+                float segmentTop = std::max(segmentBottom - (float)record.phaseMilliseconds[p] * scale, graphTop);
+                DrawRectangleRec({barX, segmentTop, 2.0f, segmentBottom - segmentTop}, PhaseColor(p));
+                segmentBottom = segmentTop;
+            }
+        }
+        int budgetY = (int)(graphBottom - 16.7f * scale);
+        DrawLine(x + 10, budgetY, x + 10 + width, budgetY, RED);
+    }
+};
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include "VoxelMath.h"
+
+// Six clip planes (a, b, c, d) facing inward: a point p is inside when a*p.x + b*p.y + c*p.z + d >= 0.
+struct Frustum
+{
+    Float4 planes[6];
+    // rows are the rows of a view-projection matrix that takes column vectors to clip space;
+    // planes are extracted from them (Gribb/Hartmann). For raylib matrices use FrustumFromMatrix
+    // in ChunkRenderer.h. The side planes can be narrowed to a sub-rectangle of normalized
+    // device coordinates.
+    static Frustum FromRows(const Float4 rows[4], float minX = -1.0f, float minY = -1.0f, float maxX = 1.0f, float maxY = 1.0f)
+    {
+        const Float4& row0 = rows[0];
+        const Float4& row1 = rows[1];
+        const Float4& row2 = rows[2];
+        const Float4& row3 = rows[3];
+        Frustum frustum;
+        frustum.planes[0] = {row0.x - minX * row3.x, row0.y - minX * row3.y, row0.z - minX * row3.z, row0.w - minX * row3.w};
+        frustum.planes[1] = {maxX * row3.x - row0.x, maxX * row3.y - row0.y, maxX * row3.z - row0.z, maxX * row3.w - row0.w};
+        frustum.planes[2] = {row1.x - minY * row3.x, row1.y - minY * row3.y, row1.z - minY * row3.z, row1.w - minY * row3.w};
+        frustum.planes[3] = {maxY * row3.x - row1.x, maxY * row3.y - row1.y, maxY * row3.z - row1.z, maxY * row3.w - row1.w};
+        frustum.planes[4] = {row3.x + row2.x, row3.y + row2.y, row3.z + row2.z, row3.w + row2.w};
+        frustum.planes[5] = {row3.x - row2.x, row3.y - row2.y, row3.z - row2.z, row3.w - row2.w};
+        return frustum;
+    }
+    // Conservative: tests the box corner furthest along each plane normal.
+    bool IntersectsBox(const Box3& box) const
+    {
+        for (const Float4& p : planes)
+        {
+            float x = p.x >= 0.0f ? box.max.x : box.min.x;
+            float y = p.y >= 0.0f ? box.max.y : box.min.y;
+            float z = p.z >= 0.0f ? box.max.z : box.min.z;
+            if (p.x * x + p.y * y + p.z * z + p.w < 0.0f) return false;
+        }
+        return true;
+    }
+};
+
+#endif
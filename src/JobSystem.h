@@ -0,0 +1,103 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// Fixed pool of worker threads pulling from one FIFO queue.
+// WaitIdle lets the calling thread drain the queue too, so blocking phases use every core.
+class JobSystem
+{
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::condition_variable jobFinished;
+    int running = 0;
+    bool stopping = false;
+    void WorkerLoop()
+    {
+        for (;;)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                jobAvailable.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (jobs.empty()) return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+                running++;
+            }
+            job();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                running--;
+            }
+            jobFinished.notify_all();
+        }
+    }
+public:
+    explicit JobSystem(int threadCount = 0)
+    {
+        if (threadCount <= 0)
+        {
+            int cores = (int)std::thread::hardware_concurrency();
+            threadCount = cores > 1 ? cores - 1 : 1;
+        }
+        for (int i = 0; i < threadCount; i++)
+        {
+            workers.emplace_back([this] { WorkerLoop(); });
+        }
+    }
+    ~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        jobAvailable.notify_all();
+        for (std::thread& worker : workers) worker.join();
+    }
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+    int WorkerCount() const
+    {
+        return (int)workers.size();
+    }
+    void Submit(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        jobAvailable.notify_one();
+    }
+    void WaitIdle()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;)
+        {
+            if (!jobs.empty())
+            {
+                std::function<void()> job = std::move(jobs.front());
+                jobs.pop_front();
+                running++;
+                lock.unlock();
+                job();
+                lock.lock();
+                running--;
+                jobFinished.notify_all();
+                continue;
+            }
+            if (running == 0) return;
+            jobFinished.wait(lock);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+
+// Read-only memory mapping of a whole file. The platform code lives in MappedFile.cpp because
+// <windows.h> cannot share a translation unit with raylib.h.
+class MappedFile
+{
+private:
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+    int descriptor = -1;
+public:
+    MappedFile() = default;
+    ~MappedFile()
+    {
+        Close();
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    bool Open(const char* path);
+    void Close();
+    bool IsOpen() const
+    {
+        return data != nullptr;
+    }
+    const unsigned char* Data() const
+    {
+        return data;
+    }
+    size_t Size() const
+    {
+        return size;
+    }
+};
+
+#endif
@@ -0,0 +1,343 @@
+#ifndef REGION_STORE_H
+#define REGION_STORE_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <thread>
+#include <filesystem>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include "ChunkMeshBuilder.h"
+#include "ChunkMap.h"
+#include "MappedFile.h"
+
+// Chunk voxels on disk, grouped into region files of 32 x 4 x 32 chunks (x, y, z).
+// File layout, little-endian:
+//   "VXRG", u32 version, then one {u32 offset, u32 size, u32 capacity} entry per chunk slot
+//   (size 0 = not stored), followed by payloads: u8 encoding (1 = RLE) and (u8 value, u16 run)
+//   triples over the voxels in memory order.
+// Loads decode straight out of a read-only mapping of the file. Saves are queued and written by
+// a dedicated thread, a region's queued saves at a time; a payload is rewritten in place when it
+// fits its slot, else appended. The files do not record the chunk size, so a world of
+// ChunkDimensions<Shift> chunks needs a directory of its own.
+template <int Shift>
+class BasicRegionStore
+{
+private:
+    static constexpr int Size = ChunkDimensions<Shift>::Size;
+    static constexpr int RegionWidth = 32;
+    static constexpr int RegionHeight = 4;
+    static constexpr int RegionChunks = RegionWidth * RegionHeight * RegionWidth;
+    static constexpr uint32_t Magic = 0x47525856;
+    static constexpr uint32_t Version = 1;
+    static constexpr size_t EntrySize = 12;
+    static constexpr size_t HeaderSize = 8 + RegionChunks * EntrySize;
+    static constexpr uint32_t SlotAlignment = 64;
+    static constexpr unsigned char EncodingRle = 1;
+    static constexpr int ChunkVolume = ChunkDimensions<Shift>::Volume;
+    static constexpr int MaxRun = 65535;
+    struct Region
+    {
+        std::shared_mutex access;
+        MappedFile file;
+        bool mapStale = true;
+        // Only touched by the save thread: the slot table as written, and where to append next.
+        bool tableLoaded = false;
+        std::vector<uint32_t> table;
+        uint32_t fileEnd = 0;
+    };
+    struct PendingSave
+    {
+        ChunkPos pos;
+        unsigned char voxels[Size][Size][Size];
+    };
+    std::string directory;
+    std::mutex regionsMutex;
+    ChunkMap<std::unique_ptr<Region>> regions;
+    std::mutex saveMutex;
+    std::condition_variable saveAvailable;
+    std::condition_variable saveFinished;
+    std::deque<std::unique_ptr<PendingSave>> saves;
+    // The newest save of each chunk that is queued or still being written; Load serves these
+    // ahead of the file, which does not have them yet.
+    ChunkMap<const PendingSave*> newestSaves;
+    int saving = 0;
+    bool stopping = false;
+    std::vector<unsigned char> encodeBuffer;
+    std::thread saver;
+    static uint32_t ReadU32(const unsigned char* p)
+    {
+        return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+    }
+    static void WriteU32(unsigned char* p, uint32_t value)
+    {
+        p[0] = (unsigned char)value;
+        p[1] = (unsigned char)(value >> 8);
+        p[2] = (unsigned char)(value >> 16);
+        p[3] = (unsigned char)(value >> 24);
+    }
+    static ChunkPos RegionOf(const ChunkPos& pos)
+    {
+        return {pos.x >> 5, pos.y >> 2, pos.z >> 5};
+    }
+    static int SlotOf(const ChunkPos& pos)
+    {
+        return ((pos.x & (RegionWidth - 1)) * RegionHeight + (pos.y & (RegionHeight - 1))) * RegionWidth + (pos.z & (RegionWidth - 1));
+    }
+    std::string PathOf(const ChunkPos& region) const
+    {
+        return directory + "/r." + std::to_string(region.x) + "." + std::to_string(region.y) + "." + std::to_string(region.z) + ".vxr";
+    }
+    Region& GetRegion(const ChunkPos& key)
+    {
+        std::lock_guard<std::mutex> lock(regionsMutex);
+        std::unique_ptr<Region>& region = regions[key];
+        if (!region) region = std::make_unique<Region>();
+        return *region;
+    }
+    static void Encode(const unsigned char* voxels, std::vector<unsigned char>& out)
+    {
+        out.clear();
+        out.push_back(EncodingRle);
+        int i = 0;
+        while (i < ChunkVolume)
+        {
+            unsigned char value = voxels[i];
+            int run = 1;
+            while (i + run < ChunkVolume && run < MaxRun && voxels[i + run] == value) run++;
+            out.push_back(value);
+            out.push_back((unsigned char)run);
+            out.push_back((unsigned char)(run >> 8));
+            i += run;
+        }
+    }
+    // Rejects anything that does not decode to exactly one chunk, so a damaged slot regenerates.
+    static bool Decode(const unsigned char* payload, size_t size, unsigned char* voxels)
+    {
+        if (size < 1 || payload[0] != EncodingRle || (size - 1) % 3 != 0) return false;
+        int filled = 0;
+        for (size_t i = 1; i < size; i += 3)
+        {
+            int run = payload[i + 1] | payload[i + 2] << 8;
+            if (run == 0 || filled + run > ChunkVolume) return false;
+            memset(voxels + filled, payload[i], run);
+            filled += run;
+        }
+        return filled == ChunkVolume;
+    }
+    static bool DecodeSlot(const MappedFile& file, int slot, unsigned char* voxels)
+    {
+        if (!file.IsOpen() || file.Size() < HeaderSize) return false;
+        const unsigned char* base = file.Data();
+        if (ReadU32(base) != Magic || ReadU32(base + 4) != Version) return false;
+        const unsigned char* entry = base + 8 + slot * EntrySize;
+        uint32_t offset = ReadU32(entry);
+        uint32_t size = ReadU32(entry + 4);
+        if (size == 0 || (size_t)offset + size > file.Size()) return false;
+        return Decode(base + offset, size, voxels);
+    }
+    // A missing or foreign file is (re)started with an empty table.
+    bool LoadTable(Region& region, FILE* f)
+    {
+        region.table.assign(RegionChunks * 3, 0);
+        std::vector<unsigned char> header(HeaderSize, 0);
+        fseek(f, 0, SEEK_END);
+        long length = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        if (length >= (long)HeaderSize && fread(header.data(), 1, HeaderSize, f) == HeaderSize &&
+            ReadU32(header.data()) == Magic && ReadU32(header.data() + 4) == Version)
+        {
+            for (int i = 0; i < RegionChunks * 3; i++) region.table[i] = ReadU32(header.data() + 8 + i * 4);
+            // The padding after the last payload is never written, so the end comes from the slots.
+            region.fileEnd = (uint32_t)length;
+            for (int slot = 0; slot < RegionChunks; slot++)
+            {
+                region.fileEnd = std::max(region.fileEnd, region.table[slot * 3] + region.table[slot * 3 + 2]);
+            }
+        }
+        else
+        {
+            std::fill(header.begin(), header.end(), 0);
+            WriteU32(header.data(), Magic);
+            WriteU32(header.data() + 4, Version);
+            fseek(f, 0, SEEK_SET);
+            if (fwrite(header.data(), 1, HeaderSize, f) != HeaderSize) return false;
+            region.fileEnd = (uint32_t)HeaderSize;
+        }
+        region.tableLoaded = true;
+        return true;
+    }
+    // Writes one chunk into the open region file. A failed or short write leaves the table in
+    // memory out of step with the file, so it is dropped and read back before the next write.
+    bool WriteChunk(Region& region, FILE* f, const PendingSave& save)
+    {
+        Encode(&save.voxels[0][0][0], encodeBuffer);
+        int slot = SlotOf(save.pos);
+        uint32_t* entry = &region.table[slot * 3];
+        uint32_t size = (uint32_t)encodeBuffer.size();
+        if (size > entry[2])
+        {
+            entry[0] = region.fileEnd;
+            entry[2] = (size + SlotAlignment - 1) / SlotAlignment * SlotAlignment;
+            region.fileEnd += entry[2];
+        }
+        entry[1] = size;
+        unsigned char packedEntry[EntrySize];
+        WriteU32(packedEntry, entry[0]);
+        WriteU32(packedEntry + 4, entry[1]);
+        WriteU32(packedEntry + 8, entry[2]);
+        bool written = fseek(f, (long)entry[0], SEEK_SET) == 0 && fwrite(encodeBuffer.data(), 1, size, f) == size &&
+            fseek(f, (long)(8 + slot * EntrySize), SEEK_SET) == 0 && fwrite(packedEntry, 1, EntrySize, f) == EntrySize;
+        if (!written) region.tableLoaded = false;
+        return written;
+    }
+    // Writes every save queued for one region with the file opened once, so a burst of saves
+    // costs the region's loaders a single remap.
+    void WriteRegion(const ChunkPos& key, const std::vector<const PendingSave*>& batch)
+    {
+        Region& region = GetRegion(key);
+        std::unique_lock<std::shared_mutex> lock(region.access);
+        region.file.Close();
+        region.mapStale = true;
+        std::string path = PathOf(key);
+        FILE* f = fopen(path.c_str(), "r+b");
+        if (!f)
+        {
+            f = fopen(path.c_str(), "w+b");
+            region.tableLoaded = false;
+        }
+        if (!f)
+        {
+            fprintf(stderr, "WARNING: REGION: Failed to open %s\n", path.c_str());
+            return;
+        }
+        for (const PendingSave* save : batch)
+        {
+            if ((!region.tableLoaded && !LoadTable(region, f)) || !WriteChunk(region, f, *save))
+            {
+                region.tableLoaded = false;
+                fprintf(stderr, "WARNING: REGION: Failed to write chunk [%d %d %d] to %s\n", save->pos.x, save->pos.y, save->pos.z, path.c_str());
+            }
+        }
+        if (fclose(f) != 0)
+        {
+            region.tableLoaded = false;
+            fprintf(stderr, "WARNING: REGION: Failed to write %s\n", path.c_str());
+        }
+    }
+    void SaveLoop()
+    {
+        std::deque<std::unique_ptr<PendingSave>> batch;
+        std::vector<const PendingSave*> regionBatch;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(saveMutex);
+                saveAvailable.wait(lock, [this] { return stopping || !saves.empty(); });
+                if (saves.empty()) return;
+                batch.swap(saves);
+                saving = (int)batch.size();
+            }
+            // Region by region, each in queue order so a chunk's last save wins.
+            while (!batch.empty())
+            {
+                ChunkPos key = RegionOf(batch.front()->pos);
+                regionBatch.clear();
+                for (const auto& save : batch)
+                {
+                    if (RegionOf(save->pos) == key) regionBatch.push_back(save.get());
+                }
+                WriteRegion(key, regionBatch);
+                {
+                    std::lock_guard<std::mutex> lock(saveMutex);
+                    for (const PendingSave* save : regionBatch)
+                    {
+                        const PendingSave** newest = newestSaves.Find(save->pos.x, save->pos.y, save->pos.z);
+                        if (newest && *newest == save) newestSaves.Erase(save->pos);
+                    }
+                    std::erase_if(batch, [&](const std::unique_ptr<PendingSave>& save) { return RegionOf(save->pos) == key; });
+                    saving = (int)batch.size();
+                }
+                saveFinished.notify_all();
+            }
+        }
+    }
+public:
+    explicit BasicRegionStore(const std::string& directory) : directory(directory)
+    {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        saver = std::thread([this] { SaveLoop(); });
+    }
+    // Writes everything still queued before returning.
+    ~BasicRegionStore()
+    {
+        {
+            std::lock_guard<std::mutex> lock(saveMutex);
+            stopping = true;
+        }
+        saveAvailable.notify_all();
+        saver.join();
+    }
+    BasicRegionStore(const BasicRegionStore&) = delete;
+    BasicRegionStore& operator=(const BasicRegionStore&) = delete;
+    // Safe from any thread. Returns false when the chunk was never saved or its data is unusable.
+    bool Load(const ChunkPos& pos, unsigned char voxels[Size][Size][Size])
+    {
+        {
+            std::lock_guard<std::mutex> lock(saveMutex);
+            if (const PendingSave** pending = newestSaves.Find(pos.x, pos.y, pos.z))
+            {
+                memcpy(voxels, (*pending)->voxels, sizeof(PendingSave::voxels));
+                return true;
+            }
+        }
+        Region& region = GetRegion(RegionOf(pos));
+        for (;;)
+        {
+            {
+                std::shared_lock<std::shared_mutex> lock(region.access);
+                if (!region.mapStale) return DecodeSlot(region.file, SlotOf(pos), &voxels[0][0][0]);
+            }
+            std::unique_lock<std::shared_mutex> lock(region.access);
+            if (region.mapStale)
+            {
+                region.file.Open(PathOf(RegionOf(pos)).c_str());
+                region.mapStale = false;
+            }
+        }
+    }
+    // Copies the voxels and returns immediately; the write happens on the save thread.
+    void SaveAsync(const ChunkPos& pos, const unsigned char voxels[Size][Size][Size])
+    {
+        std::unique_ptr<PendingSave> save = std::make_unique<PendingSave>();
+        save->pos = pos;
+        memcpy(save->voxels, voxels, sizeof(save->voxels));
+        {
+            std::lock_guard<std::mutex> lock(saveMutex);
+            newestSaves[pos] = save.get();
+            saves.push_back(std::move(save));
+        }
+        saveAvailable.notify_one();
+    }
+    void Flush()
+    {
+        std::unique_lock<std::mutex> lock(saveMutex);
+        saveFinished.wait(lock, [this] { return saves.empty() && saving == 0; });
+    }
+    int PendingSaves()
+    {
+        std::lock_guard<std::mutex> lock(saveMutex);
+        return (int)saves.size() + saving;
+    }
+};
+using RegionStore = BasicRegionStore<CHUNK_SHIFT>;
+
+#endif
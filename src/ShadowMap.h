@@ -0,0 +1,224 @@
+#ifndef SHADOW_MAP_H
+#define SHADOW_MAP_H
+
+#include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include "ChunkRenderer.h"
+
+enum class ShadowRedraw
+{
+    None,
+    Partial,
+    Full
+};
+struct ShadowStats
+{
+    ShadowRedraw redraw = ShadowRedraw::None;
+    int redrawnTexels = 0;
+    DrawStats draw;
+};
+// Cascaded shadow maps for a directional light. The camera frustum is split by distance and each
+// slice gets a square tile of one depth atlas (cascades side by side), so texels are spent where
+// the player looks instead of on a fixed box around the world.
+// A cascade is an orthographic light view around the bounding sphere of its slice. The sphere's
+// radius does not change as the camera turns and the view is snapped to whole texels, so as the
+// camera moves the shadow edges stay put instead of shimmering.
+// Each tile keeps its contents between frames: it is redrawn when its matrix changes, otherwise
+// only the texels under chunks whose meshes changed are cleared (scissored) and redrawn with the
+// chunks that overlap that part of its frustum.
+class ShadowMap
+{
+public:
+    static constexpr int CascadeCount = 3;
+private:
+    // Far end of each cascade's slice, in world units from the camera; nothing beyond the last
+    // one is shadowed.
+    static constexpr float SplitDistances[CascadeCount] = {12.0f, 40.0f, 128.0f};
+    // How far behind a cascade's center the light view starts, so casters outside the slice
+    // still land in the depth range.
+    static constexpr float LightDistance = 256.0f;
+    struct Cascade
+    {
+        Matrix lightMatrix = {0};
+        float texelSize = 0.0f;
+        bool valid = false;
+    };
+    RenderTexture2D target = {0};
+    int tileSize = 0;
+    Shader depthShader = {0};
+    Shader packedDepthShader = {0};
+    Cascade cascades[CascadeCount];
+    std::vector<Box3> changedRegions;
+    // Tile texel rectangle covered by the box in a cascade's light space, grown by a texel to
+    // absorb rounding.
+    bool ProjectRegion(const Matrix& lightMatrix, const Box3& box, int& minX, int& minY, int& maxX, int& maxY) const
+    {
+        float ndcMinX = 1.0f, ndcMinY = 1.0f, ndcMaxX = -1.0f, ndcMaxY = -1.0f;
+        for (int corner = 0; corner < 8; corner++)
+        {
+            Vector3 p = {(corner & 1) ? box.max.x : box.min.x, (corner & 2) ? box.max.y : box.min.y, (corner & 4) ? box.max.z : box.min.z};
+            const Matrix& m = lightMatrix;
+            float x = m.m0 * p.x + m.m4 * p.y + m.m8 * p.z + m.m12;
+            float y = m.m1 * p.x + m.m5 * p.y + m.m9 * p.z + m.m13;
+            ndcMinX = std::min(ndcMinX, x);
+            ndcMinY = std::min(ndcMinY, y);
+            ndcMaxX = std::max(ndcMaxX, x);
+            ndcMaxY = std::max(ndcMaxY, y);
+        }
+        minX = std::max((int)floorf((ndcMinX * 0.5f + 0.5f) * tileSize) - 1, 0);
+        minY = std::max((int)floorf((ndcMinY * 0.5f + 0.5f) * tileSize) - 1, 0);
+        maxX = std::min((int)ceilf((ndcMaxX * 0.5f + 0.5f) * tileSize) + 1, tileSize);
+        maxY = std::min((int)ceilf((ndcMaxY * 0.5f + 0.5f) * tileSize) + 1, tileSize);
+        return minX < maxX && minY < maxY;
+    }
+    // Orthographic light view around the sphere of the camera slice [nearDistance, farDistance].
+    Cascade FitCascade(const Camera3D& camera, float aspect, Vector3 lightDirection, float nearDistance, float farDistance) const
+    {
+        Vector3 forward = Vector3Normalize(Vector3Subtract(camera.target, camera.position));
+        float tanHalfFov = tanf(camera.fovy * 0.5f * DEG2RAD);
+        float halfDepth = (farDistance - nearDistance) * 0.5f;
+        float farHeight = farDistance * tanHalfFov;
+        float radius = ceilf(sqrtf(halfDepth * halfDepth + farHeight * farHeight * (1.0f + aspect * aspect)));
+        Vector3 center = Vector3Add(camera.position, Vector3Scale(forward, nearDistance + halfDepth));
+        Vector3 eye = Vector3Subtract(center, Vector3Scale(lightDirection, LightDistance));
+        Vector3 up = fabsf(lightDirection.y) > 0.99f ? Vector3 {0.0f, 0.0f, 1.0f} : Vector3 {0.0f, 1.0f, 0.0f};
+        Matrix view = MatrixLookAt(eye, center, up);
+        Matrix projection = MatrixOrtho(-radius, radius, -radius, radius, 0.0, LightDistance + radius);
+        Cascade cascade;
+        cascade.lightMatrix = MatrixMultiply(view, projection);
+        cascade.texelSize = 2.0f * radius / tileSize;
+        // Snap: shift the whole projection so the world origin lands on a texel corner.
+        float halfTile = tileSize * 0.5f;
+        Matrix& m = cascade.lightMatrix;
+        m.m12 += (roundf(m.m12 * halfTile) - m.m12 * halfTile) / halfTile;
+        m.m13 += (roundf(m.m13 * halfTile) - m.m13 * halfTile) / halfTile;
+        return cascade;
+    }
+public:
+    // A framebuffer with only a sampleable depth texture, CascadeCount tiles of tileSize squared.
+    void Load(int tileSize)
+    {
+        this->tileSize = tileSize;
+        int width = tileSize * CascadeCount;
+        target.id = rlLoadFramebuffer();
+        target.texture.width = width;
+        target.texture.height = tileSize;
+        rlEnableFramebuffer(target.id);
+        target.depth.id = rlLoadTextureDepth(width, tileSize, false);
+        target.depth.width = width;
+        target.depth.height = tileSize;
+        target.depth.mipmaps = 1;
+        rlFramebufferAttach(target.id, target.depth.id, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_TEXTURE2D, 0);
+        if (!rlFramebufferComplete(target.id)) TraceLog(LOG_WARNING, "SHADOW: Depth framebuffer is incomplete");
+        rlDisableFramebuffer();
+        depthShader = ChunkRenderer::LoadChunkShader("resources/depth.vs", "resources/depth.fs");
+        packedDepthShader = ChunkRenderer::LoadChunkShader("resources/depth_packed.vs", "resources/depth.fs");
+        Invalidate();
+    }
+    void Unload()
+    {
+        UnloadShader(depthShader);
+        UnloadShader(packedDepthShader);
+        if (target.id > 0) rlUnloadFramebuffer(target.id);
+        target = {0};
+    }
+    Texture2D GetDepthTexture() const
+    {
+        return target.depth;
+    }
+    int GetTexelCount() const
+    {
+        return target.depth.width * target.depth.height;
+    }
+    // World to light clip space of one cascade; the shader maps x into the cascade's tile.
+    Matrix GetLightMatrix(int cascade) const
+    {
+        return cascades[cascade].lightMatrix;
+    }
+    // Depth bias for the cascade in [0, 1] depth units: a texel and a half of world size, so
+    // coarser cascades do not acne.
+    float GetDepthBias(int cascade) const
+    {
+        return (cascades[cascade].texelSize * 1.5f + 0.02f) / (LightDistance + cascades[cascade].texelSize * tileSize * 0.5f);
+    }
+    void Invalidate()
+    {
+        for (Cascade& cascade : cascades) cascade.valid = false;
+    }
+    // For frames drawn without shadows: drops the regions the renderer collected, since every
+    // cascade is redrawn in full on the next Update anyway.
+    void Skip(ChunkRenderer& chunkRenderer)
+    {
+        chunkRenderer.TakeChangedRegions(changedRegions);
+        changedRegions.clear();
+        Invalidate();
+    }
+    // lightDirection points from the light into the scene; aspect is the camera's viewport aspect.
+    ShadowStats Update(ChunkRenderer& chunkRenderer, const Camera3D& camera, float aspect, Vector3 lightDirection)
+    {
+        ShadowStats stats;
+        chunkRenderer.TakeChangedRegions(changedRegions);
+        lightDirection = Vector3Normalize(lightDirection);
+        BeginTextureMode(target);
+        rlEnableDepthTest();
+        for (int c = 0; c < CascadeCount; c++)
+        {
+            Cascade fitted = FitCascade(camera, aspect, lightDirection, c == 0 ? 0.0f : SplitDistances[c - 1], SplitDistances[c]);
+            Cascade& cascade = cascades[c];
+            if (!cascade.valid || memcmp(&fitted.lightMatrix, &cascade.lightMatrix, sizeof(Matrix)) != 0)
+            {
+                cascade = fitted;
+            }
+            int minX = tileSize, minY = tileSize, maxX = 0, maxY = 0;
+            ShadowRedraw redraw = ShadowRedraw::Partial;
+            if (!cascade.valid)
+            {
+                minX = 0;
+                minY = 0;
+                maxX = tileSize;
+                maxY = tileSize;
+                redraw = ShadowRedraw::Full;
+            }
+            else
+            {
+                for (const Box3& box : changedRegions)
+                {
+                    int x0, y0, x1, y1;
+                    if (!ProjectRegion(cascade.lightMatrix, box, x0, y0, x1, y1)) continue;
+                    minX = std::min(minX, x0);
+                    minY = std::min(minY, y0);
+                    maxX = std::max(maxX, x1);
+                    maxY = std::max(maxY, y1);
+                }
+            }
+            if (minX >= maxX || minY >= maxY) continue;
+            stats.redraw = std::max(stats.redraw, redraw);
+            stats.redrawnTexels += (maxX - minX) * (maxY - minY);
+            int tileX = c * tileSize;
+            rlViewport(tileX, 0, tileSize, tileSize);
+            rlEnableScissorTest();
+            rlScissor(tileX + minX, minY, maxX - minX, maxY - minY);
+            ClearBackground(WHITE);
+            Frustum region = FrustumFromMatrix(cascade.lightMatrix, minX * 2.0f / tileSize - 1.0f, minY * 2.0f / tileSize - 1.0f, maxX * 2.0f / tileSize - 1.0f, maxY * 2.0f / tileSize - 1.0f);
+            DrawStats drawn = chunkRenderer.DrawDepth(region, cascade.lightMatrix, depthShader, packedDepthShader);
+            rlDisableScissorTest();
+            stats.draw.visibleChunks += drawn.visibleChunks;
+            stats.draw.culledChunks += drawn.culledChunks;
+            stats.draw.emptyChunks += drawn.emptyChunks;
+            stats.draw.triangles += drawn.triangles;
+            stats.draw.drawCalls += drawn.drawCalls;
+            cascade.valid = true;
+        }
+        changedRegions.clear();
+        rlDisableDepthTest();
+        EndTextureMode();
+        return stats;
+    }
+};
+
+#endif
@@ -0,0 +1,434 @@
+#ifndef TERRAIN_GENERATOR_H
+#define TERRAIN_GENERATOR_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include "ChunkMeshBuilder.h"
+#include "ChunkMap.h"
+#include "TerrainNoise.h"
+
+enum BlockId : unsigned char
+{
+    BlockAir = 0,
+    BlockStone = 1,
+    BlockDirt = 2,
+    BlockGrass = 3,
+    BlockLamp = 4
+};
+// Block light level a voxel gives off, 0 for everything but light sources.
+inline int BlockLightEmission(unsigned char block)
+{
+    return block == BlockLamp ? 14 : 0;
+}
+// Surface height of every (x, z) column in one chunk column, indexed [x][z].
+// Voxels with world y below the height are solid.
+template <int Shift>
+struct BasicColumnHeightmap
+{
+    static constexpr int Size = ChunkDimensions<Shift>::Size;
+    int heights[Size][Size];
+    int lowest;
+    int highest;
+    void UpdateRange()
+    {
+        lowest = highest = heights[0][0];
+        for (int x = 0; x < Size; x++)
+        {
+            for (int z = 0; z < Size; z++)
+            {
+                lowest = std::min(lowest, heights[x][z]);
+                highest = std::max(highest, heights[x][z]);
+            }
+        }
+    }
+};
+// Shared, compute-once storage for data that covers a region larger than one generation call,
+// keyed by chunk coordinates. Safe to call from generation jobs; two jobs racing on a new region
+// both compute it and the first insert wins.
+template <typename T>
+class RegionCache
+{
+private:
+    std::mutex mutex;
+    ChunkMap<std::shared_ptr<const T>> regions;
+    std::vector<ChunkPos> evictions;
+public:
+    template <typename Compute>
+    std::shared_ptr<const T> Get(const ChunkPos& key, Compute compute)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::shared_ptr<const T>* cached = regions.Find(key.x, key.y, key.z);
+            if (cached) return *cached;
+        }
+        std::shared_ptr<T> region = std::make_shared<T>();
+        compute(*region);
+        std::lock_guard<std::mutex> lock(mutex);
+        std::shared_ptr<const T>& slot = regions[key];
+        if (!slot) slot = region;
+        return slot;
+    }
+    // Drops regions whose horizontal squared distance from (centerX, centerZ) exceeds radius squared.
+    void EvictOutside(int centerX, int centerZ, int radius)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        evictions.clear();
+        for (auto const& [coords, region] : regions)
+        {
+            int dx = coords.x - centerX;
+            int dz = coords.z - centerZ;
+            if (dx * dx + dz * dz > radius * radius) evictions.push_back(coords);
+        }
+        for (const ChunkPos& pos : evictions) regions.Erase(pos);
+    }
+    size_t Size()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return regions.Size();
+    }
+};
+// Per-stage noise decorrelation derived from the world seed: a coordinate offset inside the
+// 256-unit noise period, so different seeds and different stages sample unrelated areas.
+struct NoiseOffset
+{
+    float x;
+    float y;
+    float z;
+    static NoiseOffset FromSeed(unsigned int seed, unsigned int stage)
+    {
+        uint64_t h = ((uint64_t)seed << 32 | stage) + 0x9E3779B97F4A7C15ull;
+        h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+        h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+        h ^= h >> 31;
+        return {(float)(h & 0xFFFF) / 256.0f, (float)((h >> 16) & 0xFFFF) / 256.0f, (float)((h >> 32) & 0xFFFF) / 256.0f};
+    }
+};
+struct TerrainSettings
+{
+    unsigned int seed = 0;
+    float heightScale = 0.008f;
+    float baseHeight = 12.0f;
+    float hillAmplitude = 6.0f;
+    float ridgeScale = 0.004f;
+    float ridgeAmplitude = 12.0f;
+    int octaves = 4;
+    float caveScale = 0.05f;
+    float caveThreshold = 0.32f;
+    int caveRoof = 3;
+};
+// One chunk on its way through the pipeline. The height stage publishes its column heightmap
+// here so later stages can reason about the surface without resampling it.
+template <int Shift>
+struct BasicTerrainChunk
+{
+    int cx;
+    int cy;
+    int cz;
+    unsigned char (*voxels)[ChunkDimensions<Shift>::Size][ChunkDimensions<Shift>::Size];
+    std::shared_ptr<const BasicColumnHeightmap<Shift>> heightmap;
+};
+// Stages, like the rest of the pipeline, are built for one chunk size; the aliases after
+// TerrainGenerator name the engine's.
+template <int Shift>
+class BasicTerrainStage
+{
+public:
+    virtual ~BasicTerrainStage() = default;
+    virtual void Apply(BasicTerrainChunk<Shift>& chunk) = 0;
+    // Lets stages with caches forget regions the world has moved away from.
+    virtual void EvictOutside(int, int, int) {}
+};
+// Within each x-slice, rows below the lowest column are filled with one memset and rows above the
+// highest are left as cleared air; only the rows in between compare per voxel.
+template <int Shift>
+void FillBelowHeightmap(BasicTerrainChunk<Shift>& chunk, const BasicColumnHeightmap<Shift>& heightmap, unsigned char block)
+{
+    constexpr int Size = ChunkDimensions<Shift>::Size;
+    int baseY = chunk.cy * Size;
+    if (baseY >= heightmap.highest) return;
+    for (int x = 0; x < Size; x++)
+    {
+        const int* heights = heightmap.heights[x];
+        int lowest = heights[0];
+        int highest = heights[0];
+        for (int z = 1; z < Size; z++)
+        {
+            lowest = std::min(lowest, heights[z]);
+            highest = std::max(highest, heights[z]);
+        }
+        int solidRows = std::clamp(lowest - baseY, 0, Size);
+        int mixedEnd = std::clamp(highest - baseY, 0, Size);
+        memset(chunk.voxels[x][0], block, (size_t)solidRows * Size);
+        for (int y = solidRows; y < mixedEnd; y++)
+        {
+            for (int z = 0; z < Size; z++)
+            {
+                chunk.voxels[x][y][z] = (baseY + y < heights[z]) ? block : (unsigned char)BlockAir;
+            }
+        }
+    }
+}
+// The original terrain: one octave of unseeded Perlin noise per column, 8 + noise * 10 high.
+template <int Shift>
+class BasicClassicHeightStage : public BasicTerrainStage<Shift>
+{
+private:
+    static constexpr int Size = ChunkDimensions<Shift>::Size;
+    RegionCache<BasicColumnHeightmap<Shift>> columns;
+    static void Compute(int cx, int cz, BasicColumnHeightmap<Shift>& out)
+    {
+        const int count = Size * Size;
+        float xs[count], ys[count], zs[count], noise[count];
+        for (int x = 0; x < Size; x++)
+        {
+            for (int z = 0; z < Size; z++)
+            {
+                float worldX = (float)(cx * Size + x);
+                float worldZ = (float)(cz * Size + z);
+                xs[x * Size + z] = worldX * 0.03f;
+                ys[x * Size + z] = 0.0f;
+                zs[x * Size + z] = worldZ * 0.03f;
+            }
+        }
+        TerrainNoise::Noise3Batch(xs, ys, zs, count, noise);
+        for (int x = 0; x < Size; x++)
+        {
+            for (int z = 0; z < Size; z++)
+            {
+                out.heights[x][z] = (int)(8 + noise[x * Size + z] * 10);
+            }
+        }
+        out.UpdateRange();
+    }
+public:
+    void Apply(BasicTerrainChunk<Shift>& chunk) override
+    {
+        int cx = chunk.cx;
+        int cz = chunk.cz;
+        chunk.heightmap = columns.Get({cx, 0, cz}, [cx, cz](BasicColumnHeightmap<Shift>& out) { Compute(cx, cz, out); });
+        FillBelowHeightmap(chunk, *chunk.heightmap, BlockStone);
+    }
+    void EvictOutside(int centerX, int centerZ, int radius) override
+    {
+        columns.EvictOutside(centerX, centerZ, radius);
+    }
+};
+// Rolling fBm hills plus ridged mountains. Both fields are low frequency, so they are sampled on a
+// lattice every HeightStep voxels (aligned to world coordinates, so chunk borders agree) and
+// bilinearly interpolated.
+template <int Shift>
+class BasicFbmHeightStage : public BasicTerrainStage<Shift>
+{
+private:
+    static constexpr int Size = ChunkDimensions<Shift>::Size;
+    static constexpr int HeightStep = 4;
+    static constexpr int LatticeSize = Size / HeightStep + 1;
+    TerrainSettings settings;
+    NoiseOffset hillOffset;
+    NoiseOffset ridgeOffset;
+    RegionCache<BasicColumnHeightmap<Shift>> columns;
+    void Compute(int cx, int cz, BasicColumnHeightmap<Shift>& out) const
+    {
+        const int count = LatticeSize * LatticeSize;
+        float hx[count], hy[count], hz[count], rx[count], ry[count], rz[count], hills[count], ridges[count];
+        for (int i = 0; i < LatticeSize; i++)
+        {
+            for (int j = 0; j < LatticeSize; j++)
+            {
+                float worldX = (float)(cx * Size + i * HeightStep);
+                float worldZ = (float)(cz * Size + j * HeightStep);
+                int k = i * LatticeSize + j;
+                hx[k] = worldX * settings.heightScale + hillOffset.x;
+                hy[k] = hillOffset.y;
+                hz[k] = worldZ * settings.heightScale + hillOffset.z;
+                rx[k] = worldX * settings.ridgeScale + ridgeOffset.x;
+                ry[k] = ridgeOffset.y;
+                rz[k] = worldZ * settings.ridgeScale + ridgeOffset.z;
+            }
+        }
+        TerrainNoise::Fbm3Batch(hx, hy, hz, count, hills, 2.0f, 0.5f, settings.octaves);
+        TerrainNoise::Ridge3Batch(rx, ry, rz, count, ridges, 2.0f, 0.5f, 1.0f, settings.octaves);
+        float lattice[LatticeSize][LatticeSize];
+        for (int i = 0; i < LatticeSize; i++)
+        {
+            for (int j = 0; j < LatticeSize; j++)
+            {
+                int k = i * LatticeSize + j;
+                lattice[i][j] = settings.baseHeight + hills[k] * settings.hillAmplitude + ridges[k] * settings.ridgeAmplitude;
+            }
+        }
+        const float inverseStep = 1.0f / HeightStep;
+        for (int x = 0; x < Size; x++)
+        {
+            int i = x / HeightStep;
+            float tx = (x % HeightStep) * inverseStep;
+            for (int z = 0; z < Size; z++)
+            {
+                int j = z / HeightStep;
+                float tz = (z % HeightStep) * inverseStep;
+                float low = lattice[i][j] + (lattice[i][j + 1] - lattice[i][j]) * tz;
+                float high = lattice[i + 1][j] + (lattice[i + 1][j + 1] - lattice[i + 1][j]) * tz;
+                out.heights[x][z] = (int)floorf(low + (high - low) * tx);
+            }
+        }
+        out.UpdateRange();
+    }
+public:
+    explicit BasicFbmHeightStage(const TerrainSettings& settings)
+        : settings(settings), hillOffset(NoiseOffset::FromSeed(settings.seed, 1)), ridgeOffset(NoiseOffset::FromSeed(settings.seed, 2)) {}
+    void Apply(BasicTerrainChunk<Shift>& chunk) override
+    {
+        int cx = chunk.cx;
+        int cz = chunk.cz;
+        chunk.heightmap = columns.Get({cx, 0, cz}, [this, cx, cz](BasicColumnHeightmap<Shift>& out) { Compute(cx, cz, out); });
+        FillBelowHeightmap(chunk, *chunk.heightmap, BlockStone);
+    }
+    void EvictOutside(int centerX, int centerZ, int radius) override
+    {
+        columns.EvictOutside(centerX, centerZ, radius);
+    }
+};
+// Carves caves where a 3D fBm density exceeds the threshold, at least caveRoof voxels under the
+// surface and never through world y = 0. Density is sampled on a 4-voxel lattice (125 samples
+// instead of 4096 per chunk) and trilinearly interpolated; chunks with nothing solid skip it.
+// Each chunk is generated once, so the lattice is not kept after the call.
+template <int Shift>
+class BasicCaveStage : public BasicTerrainStage<Shift>
+{
+private:
+    static constexpr int Size = ChunkDimensions<Shift>::Size;
+    static constexpr int DensityStep = 4;
+    static constexpr int LatticeSize = Size / DensityStep + 1;
+    TerrainSettings settings;
+    NoiseOffset offset;
+public:
+    explicit BasicCaveStage(const TerrainSettings& settings)
+        : settings(settings), offset(NoiseOffset::FromSeed(settings.seed, 3)) {}
+    void Apply(BasicTerrainChunk<Shift>& chunk) override
+    {
+        if (!chunk.heightmap) return;
+        const BasicColumnHeightmap<Shift>& heightmap = *chunk.heightmap;
+        int baseY = chunk.cy * Size;
+        if (baseY >= heightmap.highest - settings.caveRoof) return;
+        const int count = LatticeSize * LatticeSize * LatticeSize;
+        float xs[count], ys[count], zs[count], density[count];
+        for (int i = 0; i < LatticeSize; i++)
+        {
+            for (int j = 0; j < LatticeSize; j++)
+            {
+                for (int k = 0; k < LatticeSize; k++)
+                {
+                    int n = (i * LatticeSize + j) * LatticeSize + k;
+                    xs[n] = (float)(chunk.cx * Size + i * DensityStep) * settings.caveScale + offset.x;
+                    ys[n] = (float)(baseY + j * DensityStep) * settings.caveScale * 1.5f + offset.y;
+                    zs[n] = (float)(chunk.cz * Size + k * DensityStep) * settings.caveScale + offset.z;
+                }
+            }
+        }
+        TerrainNoise::Fbm3Batch(xs, ys, zs, count, density, 2.0f, 0.5f, 2);
+        auto at = [&density](int i, int j, int k) { return density[(i * LatticeSize + j) * LatticeSize + k]; };
+        const float inverseStep = 1.0f / DensityStep;
+        for (int x = 0; x < Size; x++)
+        {
+            int i = x / DensityStep;
+            float tx = (x % DensityStep) * inverseStep;
+            for (int y = 0; y < Size; y++)
+            {
+                int worldY = baseY + y;
+                if (worldY <= 0) continue;
+                int j = y / DensityStep;
+                float ty = (y % DensityStep) * inverseStep;
+                for (int z = 0; z < Size; z++)
+                {
+                    if (worldY >= heightmap.heights[x][z] - settings.caveRoof) continue;
+                    int k = z / DensityStep;
+                    float tz = (z % DensityStep) * inverseStep;
+                    float d00 = at(i, j, k) + (at(i, j, k + 1) - at(i, j, k)) * tz;
+                    float d01 = at(i, j + 1, k) + (at(i, j + 1, k + 1) - at(i, j + 1, k)) * tz;
+                    float d10 = at(i + 1, j, k) + (at(i + 1, j, k + 1) - at(i + 1, j, k)) * tz;
+                    float d11 = at(i + 1, j + 1, k) + (at(i + 1, j + 1, k + 1) - at(i + 1, j + 1, k)) * tz;
+                    float d0 = d00 + (d01 - d00) * ty;
+                    float d1 = d10 + (d11 - d10) * ty;
+                    if (d0 + (d1 - d0) * tx > settings.caveThreshold) chunk.voxels[x][y][z] = BlockAir;
+                }
+            }
+        }
+    }
+};
+// Turns the top of every column into grass over three layers of dirt, reading the heightmap
+// rather than neighboring voxels so it never needs the chunk above.
+template <int Shift>
+class BasicSurfaceStage : public BasicTerrainStage<Shift>
+{
+public:
+    void Apply(BasicTerrainChunk<Shift>& chunk) override
+    {
+        constexpr int Size = ChunkDimensions<Shift>::Size;
+        if (!chunk.heightmap) return;
+        const BasicColumnHeightmap<Shift>& heightmap = *chunk.heightmap;
+        int baseY = chunk.cy * Size;
+        if (baseY >= heightmap.highest || baseY + Size < heightmap.lowest - 4) return;
+        for (int x = 0; x < Size; x++)
+        {
+            for (int z = 0; z < Size; z++)
+            {
+                int height = heightmap.heights[x][z];
+                int from = std::max(height - 4 - baseY, 0);
+                int to = std::min(height - baseY, Size);
+                for (int y = from; y < to; y++)
+                {
+                    if (chunk.voxels[x][y][z] == BlockAir) continue;
+                    chunk.voxels[x][y][z] = (baseY + y == height - 1) ? BlockGrass : BlockDirt;
+                }
+            }
+        }
+    }
+};
+// Runs its stages in order over a cleared chunk. Stages must be safe to call from several
+// generation jobs at once.
+template <int Shift>
+class BasicTerrainGenerator
+{
+private:
+    static constexpr int Size = ChunkDimensions<Shift>::Size;
+    std::vector<std::unique_ptr<BasicTerrainStage<Shift>>> stages;
+public:
+    void AddStage(std::unique_ptr<BasicTerrainStage<Shift>> stage)
+    {
+        stages.push_back(std::move(stage));
+    }
+    void Generate(int cx, int cy, int cz, unsigned char voxels[Size][Size][Size])
+    {
+        memset(voxels, BlockAir, (size_t)Size * Size * Size);
+        BasicTerrainChunk<Shift> chunk {cx, cy, cz, voxels, nullptr};
+        for (const std::unique_ptr<BasicTerrainStage<Shift>>& stage : stages) stage->Apply(chunk);
+    }
+    void EvictOutside(int centerX, int centerZ, int radius)
+    {
+        for (const std::unique_ptr<BasicTerrainStage<Shift>>& stage : stages) stage->EvictOutside(centerX, centerZ, radius);
+    }
+    static std::unique_ptr<BasicTerrainGenerator> CreateClassic()
+    {
+        std::unique_ptr<BasicTerrainGenerator> generator = std::make_unique<BasicTerrainGenerator>();
+        generator->AddStage(std::make_unique<BasicClassicHeightStage<Shift>>());
+        return generator;
+    }
+    static std::unique_ptr<BasicTerrainGenerator> CreateDefault(const TerrainSettings& settings)
+    {
+        std::unique_ptr<BasicTerrainGenerator> generator = std::make_unique<BasicTerrainGenerator>();
+        generator->AddStage(std::make_unique<BasicFbmHeightStage<Shift>>(settings));
+        generator->AddStage(std::make_unique<BasicCaveStage<Shift>>(settings));
+        generator->AddStage(std::make_unique<BasicSurfaceStage<Shift>>());
+        return generator;
+    }
+};
+using ColumnHeightmap = BasicColumnHeightmap<CHUNK_SHIFT>;
+using TerrainChunk = BasicTerrainChunk<CHUNK_SHIFT>;
+using TerrainStage = BasicTerrainStage<CHUNK_SHIFT>;
+using TerrainGenerator = BasicTerrainGenerator<CHUNK_SHIFT>;
+
+#endif
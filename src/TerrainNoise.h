@@ -0,0 +1,252 @@
+#ifndef TERRAIN_NOISE_H
+#define TERRAIN_NOISE_H
+
+#define STB_PERLIN_IMPLEMENTATION
+#include "stb_perlin.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TERRAIN_NOISE_LANES 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TERRAIN_NOISE_LANES 4
+#else
+#define TERRAIN_NOISE_LANES 1
+#endif
+
+// Batched stb_perlin_noise3. The lane kernel performs the same float operations in the same
+// order as stb_perlin_noise3_internal, so every lane returns exactly what stb would.
+// AVX2 evaluates 8 points per step, SSE2 4; anything left over goes through stb itself.
+namespace TerrainNoise
+{
+    struct Tables
+    {
+        int permutation[512];
+        int gradientIndex[512];
+        float basisX[12];
+        float basisY[12];
+        float basisZ[12];
+    };
+    inline const Tables& GetTables()
+    {
+        static const Tables tables = []
+            {
+                Tables t;
+                for (int i = 0; i < 512; i++)
+                {
+                    t.permutation[i] = stb__perlin_randtab[i];
+                    t.gradientIndex[i] = stb__perlin_randtab_grad_idx[i];
+                }
+                const float basis[12][3] = {
+                    {1, 1, 0}, {-1, 1, 0}, {1, -1, 0}, {-1, -1, 0},
+                    {1, 0, 1}, {-1, 0, 1}, {1, 0, -1}, {-1, 0, -1},
+                    {0, 1, 1}, {0, -1, 1}, {0, 1, -1}, {0, -1, -1}};
+                for (int i = 0; i < 12; i++)
+                {
+                    t.basisX[i] = basis[i][0];
+                    t.basisY[i] = basis[i][1];
+                    t.basisZ[i] = basis[i][2];
+                }
+                return t;
+            }();
+        return tables;
+    }
+#if TERRAIN_NOISE_LANES == 8
+    using Floats = __m256;
+    using Ints = __m256i;
+    inline Floats LoadFloats(const float* p) { return _mm256_loadu_ps(p); }
+    inline void StoreFloats(float* p, Floats v) { _mm256_storeu_ps(p, v); }
+    inline Floats SetFloats(float v) { return _mm256_set1_ps(v); }
+    inline Ints SetInts(int v) { return _mm256_set1_epi32(v); }
+    inline Floats Add(Floats a, Floats b) { return _mm256_add_ps(a, b); }
+    inline Floats Sub(Floats a, Floats b) { return _mm256_sub_ps(a, b); }
+    inline Floats Mul(Floats a, Floats b) { return _mm256_mul_ps(a, b); }
+    inline Ints AddInts(Ints a, Ints b) { return _mm256_add_epi32(a, b); }
+    inline Ints AndInts(Ints a, Ints b) { return _mm256_and_si256(a, b); }
+    inline Floats ToFloats(Ints a) { return _mm256_cvtepi32_ps(a); }
+    // (int)a, minus one where a < (int)a: stb__perlin_fastfloor.
+    inline Ints FastFloor(Floats a)
+    {
+        Ints truncated = _mm256_cvttps_epi32(a);
+        Floats below = _mm256_cmp_ps(a, _mm256_cvtepi32_ps(truncated), _CMP_LT_OQ);
+        return _mm256_add_epi32(truncated, _mm256_castps_si256(below));
+    }
+    inline Ints GatherInts(const int* table, Ints index) { return _mm256_i32gather_epi32(table, index, 4); }
+    inline Floats GatherFloats(const float* table, Ints index) { return _mm256_i32gather_ps(table, index, 4); }
+#elif TERRAIN_NOISE_LANES == 4
+    using Floats = __m128;
+    using Ints = __m128i;
+    inline Floats LoadFloats(const float* p) { return _mm_loadu_ps(p); }
+    inline void StoreFloats(float* p, Floats v) { _mm_storeu_ps(p, v); }
+    inline Floats SetFloats(float v) { return _mm_set1_ps(v); }
+    inline Ints SetInts(int v) { return _mm_set1_epi32(v); }
+    inline Floats Add(Floats a, Floats b) { return _mm_add_ps(a, b); }
+    inline Floats Sub(Floats a, Floats b) { return _mm_sub_ps(a, b); }
+    inline Floats Mul(Floats a, Floats b) { return _mm_mul_ps(a, b); }
+    inline Ints AddInts(Ints a, Ints b) { return _mm_add_epi32(a, b); }
+    inline Ints AndInts(Ints a, Ints b) { return _mm_and_si128(a, b); }
+    inline Floats ToFloats(Ints a) { return _mm_cvtepi32_ps(a); }
+    inline Ints FastFloor(Floats a)
+    {
+        Ints truncated = _mm_cvttps_epi32(a);
+        Floats below = _mm_cmplt_ps(a, _mm_cvtepi32_ps(truncated));
+        return _mm_add_epi32(truncated, _mm_castps_si128(below));
+    }
+    // SSE2 has no gather; the four lookups are done through memory.
+    inline Ints GatherInts(const int* table, Ints index)
+    {
+        alignas(16) int i[4];
+        _mm_store_si128((Ints*)i, index);
+        return _mm_setr_epi32(table[i[0]], table[i[1]], table[i[2]], table[i[3]]);
+    }
+    inline Floats GatherFloats(const float* table, Ints index)
+    {
+        alignas(16) int i[4];
+        _mm_store_si128((Ints*)i, index);
+        return _mm_setr_ps(table[i[0]], table[i[1]], table[i[2]], table[i[3]]);
+    }
+#endif
+#if TERRAIN_NOISE_LANES > 1
+    inline Floats Ease(Floats a)
+    {
+        Floats t = Add(Mul(Sub(Mul(a, SetFloats(6.0f)), SetFloats(15.0f)), a), SetFloats(10.0f));
+        return Mul(Mul(Mul(t, a), a), a);
+    }
+    inline Floats Lerp(Floats a, Floats b, Floats t)
+    {
+        return Add(a, Mul(Sub(b, a), t));
+    }
+    inline Floats Gradient(const Tables& tables, Ints hash, Floats x, Floats y, Floats z)
+    {
+        Ints g = GatherInts(tables.gradientIndex, hash);
+        Floats gx = GatherFloats(tables.basisX, g);
+        Floats gy = GatherFloats(tables.basisY, g);
+        Floats gz = GatherFloats(tables.basisZ, g);
+        return Add(Add(Mul(gx, x), Mul(gy, y)), Mul(gz, z));
+    }
+    inline void NoiseLanes(const float* xs, const float* ys, const float* zs, float* out, int seed)
+    {
+        const Tables& tables = GetTables();
+        Floats x = LoadFloats(xs);
+        Floats y = LoadFloats(ys);
+        Floats z = LoadFloats(zs);
+        Ints px = FastFloor(x);
+        Ints py = FastFloor(y);
+        Ints pz = FastFloor(z);
+        Ints mask = SetInts(255);
+        Ints one = SetInts(1);
+        Ints x0 = AndInts(px, mask), x1 = AndInts(AddInts(px, one), mask);
+        Ints y0 = AndInts(py, mask), y1 = AndInts(AddInts(py, one), mask);
+        Ints z0 = AndInts(pz, mask), z1 = AndInts(AddInts(pz, one), mask);
+        x = Sub(x, ToFloats(px));
+        y = Sub(y, ToFloats(py));
+        z = Sub(z, ToFloats(pz));
+        Floats u = Ease(x);
+        Floats v = Ease(y);
+        Floats w = Ease(z);
+        Ints r0 = GatherInts(tables.permutation, AddInts(x0, SetInts(seed)));
+        Ints r1 = GatherInts(tables.permutation, AddInts(x1, SetInts(seed)));
+        Ints r00 = GatherInts(tables.permutation, AddInts(r0, y0));
+        Ints r01 = GatherInts(tables.permutation, AddInts(r0, y1));
+        Ints r10 = GatherInts(tables.permutation, AddInts(r1, y0));
+        Ints r11 = GatherInts(tables.permutation, AddInts(r1, y1));
+        Floats fone = SetFloats(1.0f);
+        Floats xm = Sub(x, fone);
+        Floats ym = Sub(y, fone);
+        Floats zm = Sub(z, fone);
+        Floats n000 = Gradient(tables, AddInts(r00, z0), x, y, z);
+        Floats n001 = Gradient(tables, AddInts(r00, z1), x, y, zm);
+        Floats n010 = Gradient(tables, AddInts(r01, z0), x, ym, z);
+        Floats n011 = Gradient(tables, AddInts(r01, z1), x, ym, zm);
+        Floats n100 = Gradient(tables, AddInts(r10, z0), xm, y, z);
+        Floats n101 = Gradient(tables, AddInts(r10, z1), xm, y, zm);
+        Floats n110 = Gradient(tables, AddInts(r11, z0), xm, ym, z);
+        Floats n111 = Gradient(tables, AddInts(r11, z1), xm, ym, zm);
+        Floats n00 = Lerp(n000, n001, w);
+        Floats n01 = Lerp(n010, n011, w);
+        Floats n10 = Lerp(n100, n101, w);
+        Floats n11 = Lerp(n110, n111, w);
+        Floats n0 = Lerp(n00, n01, v);
+        Floats n1 = Lerp(n10, n11, v);
+        StoreFloats(out, Lerp(n0, n1, u));
+    }
+#endif
+    // out[i] = stb_perlin_noise3_seed(xs[i], ys[i], zs[i], 0, 0, 0, seed) for every i < count.
+    inline void Noise3Batch(const float* xs, const float* ys, const float* zs, int count, float* out, unsigned char seed = 0)
+    {
+        int i = 0;
+#if TERRAIN_NOISE_LANES > 1
+        for (; i + TERRAIN_NOISE_LANES <= count; i += TERRAIN_NOISE_LANES)
+        {
+            NoiseLanes(xs + i, ys + i, zs + i, out + i, seed);
+        }
+#endif
+        for (; i < count; i++)
+        {
+            out[i] = stb_perlin_noise3_internal(xs[i], ys[i], zs[i], 0, 0, 0, seed);
+        }
+    }
+    // Batched stb_perlin_fbm_noise3 and stb_perlin_ridge_noise3, with the same per-octave float
+    // math; points are processed in blocks so the scaled coordinates stay on the stack.
+    const int OctaveBlock = 64;
+    inline void Fbm3Batch(const float* xs, const float* ys, const float* zs, int count, float* out, float lacunarity, float gain, int octaves)
+    {
+        float sx[OctaveBlock], sy[OctaveBlock], sz[OctaveBlock], noise[OctaveBlock];
+        for (int start = 0; start < count; start += OctaveBlock)
+        {
+            int n = count - start < OctaveBlock ? count - start : OctaveBlock;
+            float frequency = 1.0f;
+            float amplitude = 1.0f;
+            for (int i = 0; i < n; i++) out[start + i] = 0.0f;
+            for (int octave = 0; octave < octaves; octave++)
+            {
+                for (int i = 0; i < n; i++)
+                {
+                    sx[i] = xs[start + i] * frequency;
+                    sy[i] = ys[start + i] * frequency;
+                    sz[i] = zs[start + i] * frequency;
+                }
+                Noise3Batch(sx, sy, sz, n, noise, (unsigned char)octave);
+                for (int i = 0; i < n; i++) out[start + i] += noise[i] * amplitude;
+                frequency *= lacunarity;
+                amplitude *= gain;
+            }
+        }
+    }
+    inline void Ridge3Batch(const float* xs, const float* ys, const float* zs, int count, float* out, float lacunarity, float gain, float offset, int octaves)
+    {
+        float sx[OctaveBlock], sy[OctaveBlock], sz[OctaveBlock], noise[OctaveBlock], prev[OctaveBlock];
+        for (int start = 0; start < count; start += OctaveBlock)
+        {
+            int n = count - start < OctaveBlock ? count - start : OctaveBlock;
+            float frequency = 1.0f;
+            float amplitude = 0.5f;
+            for (int i = 0; i < n; i++)
+            {
+                out[start + i] = 0.0f;
+                prev[i] = 1.0f;
+            }
+            for (int octave = 0; octave < octaves; octave++)
+            {
+                for (int i = 0; i < n; i++)
+                {
+                    sx[i] = xs[start + i] * frequency;
+                    sy[i] = ys[start + i] * frequency;
+                    sz[i] = zs[start + i] * frequency;
+                }
+                Noise3Batch(sx, sy, sz, n, noise, (unsigned char)octave);
+                for (int i = 0; i < n; i++)
+                {
+                    float r = offset - (float)fabs(noise[i]);
+                    r = r * r;
+                    out[start + i] += r * amplitude * prev[i];
+                    prev[i] = r;
+                }
+                frequency *= lacunarity;
+                amplitude *= gain;
+            }
+        }
+    }
+}
+
+#endif
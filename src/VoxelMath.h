@@ -0,0 +1,30 @@
+#ifndef VOXEL_MATH_H
+#define VOXEL_MATH_H
+
+// The few vector types the voxel world and the mesher need. They stand in for raylib's so those
+// headers build without it (the bench links neither raylib nor GL); ChunkRenderer.h converts.
+struct Float2
+{
+    float x, y;
+};
+struct Float3
+{
+    float x, y, z;
+};
+struct Float4
+{
+    float x, y, z, w;
+};
+struct Box3
+{
+    Float3 min;
+    Float3 max;
+};
+// direction need not be normalized.
+struct Ray3
+{
+    Float3 position;
+    Float3 direction;
+};
+
+#endif
@@ -0,0 +1,252 @@
+#ifndef VOXEL_STORAGE_H
+#define VOXEL_STORAGE_H
+
+#include <memory>
+#include <cstring>
+#include <cstdint>
+#include "ChunkMeshBuilder.h"
+
+enum class VoxelStorageMode
+{
+    Uniform,
+    Palette,
+    Dense
+};
+// Voxels of one chunk of ChunkDimensions<Shift> in the smallest of three forms:
+//   Uniform - every voxel has the same id; no allocation at all.
+//   Palette - up to 16 distinct ids, stored as 1, 2 or 4-bit indices packed into 64-bit words.
+//   Dense   - the plain [x][y][z] byte array.
+// Assign picks the smallest form for a full chunk; Set promotes in place (uniform -> palette ->
+// wider palette -> dense) when a write needs it and never demotes. Voxel order is the same as the
+// dense array, so a z-row is a contiguous run of indices: inside one word, or whole words once a
+// row is 64 bits or more.
+template <int Shift>
+class BasicVoxelStorage
+{
+public:
+    using Mode = VoxelStorageMode;
+    static constexpr int Size = ChunkDimensions<Shift>::Size;
+    static constexpr int Volume = ChunkDimensions<Shift>::Volume;
+private:
+    static constexpr int MaxPalette = 16;
+    Mode mode = Mode::Uniform;
+    unsigned char uniform = 0;
+    int bits = 0;
+    int paletteSize = 0;
+    unsigned char palette[MaxPalette];
+    std::unique_ptr<uint64_t[]> indices;
+    std::unique_ptr<unsigned char[]> dense;
+    static int IndexOf(int x, int y, int z)
+    {
+        return (x * Size + y) * Size + z;
+    }
+    static int BitsFor(int count)
+    {
+        return count <= 2 ? 1 : (count <= 4 ? 2 : 4);
+    }
+    int WordCount() const
+    {
+        return Volume * bits / 64;
+    }
+    unsigned int ReadIndex(int i) const
+    {
+        int bit = i * bits;
+        return (unsigned int)(indices[bit >> 6] >> (bit & 63)) & ((1u << bits) - 1);
+    }
+    void WriteIndex(int i, unsigned int index)
+    {
+        int bit = i * bits;
+        uint64_t mask = ((1ull << bits) - 1) << (bit & 63);
+        indices[bit >> 6] = (indices[bit >> 6] & ~mask) | ((uint64_t)index << (bit & 63));
+    }
+    int FindInPalette(unsigned char value) const
+    {
+        for (int i = 0; i < paletteSize; i++)
+        {
+            if (palette[i] == value) return i;
+        }
+        return -1;
+    }
+    void Reset()
+    {
+        indices.reset();
+        dense.reset();
+        bits = 0;
+        paletteSize = 0;
+    }
+    // Re-packs the current palette indices at a new width.
+    void RepackIndices(int newBits)
+    {
+        std::unique_ptr<uint64_t[]> old = std::move(indices);
+        int oldBits = bits;
+        bits = newBits;
+        indices = std::make_unique<uint64_t[]>(WordCount());
+        for (int i = 0; i < Volume; i++)
+        {
+            int bit = i * oldBits;
+            WriteIndex(i, (unsigned int)(old[bit >> 6] >> (bit & 63)) & ((1u << oldBits) - 1));
+        }
+    }
+    void ToDense()
+    {
+        std::unique_ptr<unsigned char[]> expanded = std::make_unique<unsigned char[]>(Volume);
+        CopyTo(expanded.get());
+        Reset();
+        dense = std::move(expanded);
+        mode = Mode::Dense;
+    }
+public:
+    Mode GetMode() const
+    {
+        return mode;
+    }
+    bool IsUniform(unsigned char& value) const
+    {
+        value = uniform;
+        return mode == Mode::Uniform;
+    }
+    size_t ResidentBytes() const
+    {
+        if (mode == Mode::Dense) return Volume;
+        if (mode == Mode::Palette) return (size_t)WordCount() * sizeof(uint64_t);
+        return 0;
+    }
+    unsigned char Get(int x, int y, int z) const
+    {
+        if (mode == Mode::Uniform) return uniform;
+        int i = IndexOf(x, y, z);
+        if (mode == Mode::Dense) return dense[i];
+        return palette[ReadIndex(i)];
+    }
+    void Set(int x, int y, int z, unsigned char value)
+    {
+        int i = IndexOf(x, y, z);
+        if (mode == Mode::Dense)
+        {
+            dense[i] = value;
+            return;
+        }
+        if (mode == Mode::Uniform)
+        {
+            if (value == uniform) return;
+            palette[0] = uniform;
+            paletteSize = 1;
+            bits = 1;
+            indices = std::make_unique<uint64_t[]>(WordCount());
+            mode = Mode::Palette;
+        }
+        int index = FindInPalette(value);
+        if (index < 0)
+        {
+            if (paletteSize == MaxPalette)
+            {
+                ToDense();
+                dense[i] = value;
+                return;
+            }
+            if (paletteSize == (1 << bits)) RepackIndices(bits * 2);
+            index = paletteSize;
+            palette[paletteSize++] = value;
+        }
+        WriteIndex(i, (unsigned int)index);
+    }
+    // Replaces the contents with a full dense chunk, choosing the smallest representation.
+    void Assign(const unsigned char* voxels)
+    {
+        int slotOf[256];
+        memset(slotOf, -1, sizeof(slotOf));
+        int distinct = 0;
+        unsigned char values[MaxPalette];
+        for (int i = 0; i < Volume && distinct <= MaxPalette; i++)
+        {
+            if (slotOf[voxels[i]] >= 0) continue;
+            if (distinct < MaxPalette) values[distinct] = voxels[i];
+            slotOf[voxels[i]] = distinct++;
+        }
+        Reset();
+        if (distinct == 1)
+        {
+            mode = Mode::Uniform;
+            uniform = voxels[0];
+            return;
+        }
+        if (distinct > MaxPalette)
+        {
+            mode = Mode::Dense;
+            dense = std::make_unique<unsigned char[]>(Volume);
+            memcpy(dense.get(), voxels, Volume);
+            return;
+        }
+        mode = Mode::Palette;
+        paletteSize = distinct;
+        memcpy(palette, values, distinct);
+        bits = BitsFor(distinct);
+        indices = std::make_unique<uint64_t[]>(WordCount());
+        int perWord = 64 / bits;
+        for (int word = 0; word < WordCount(); word++)
+        {
+            uint64_t packed = 0;
+            const unsigned char* source = voxels + word * perWord;
+            for (int j = 0; j < perWord; j++) packed |= (uint64_t)slotOf[source[j]] << (j * bits);
+            indices[word] = packed;
+        }
+    }
+    void Assign(const unsigned char voxels[Size][Size][Size])
+    {
+        Assign(&voxels[0][0][0]);
+    }
+    void Fill(unsigned char value)
+    {
+        Reset();
+        mode = Mode::Uniform;
+        uniform = value;
+    }
+    // The Size voxels of the z-row at (x, y).
+    void CopyRow(int x, int y, unsigned char* out) const
+    {
+        if (mode == Mode::Uniform)
+        {
+            memset(out, uniform, Size);
+            return;
+        }
+        int i = IndexOf(x, y, 0);
+        if (mode == Mode::Dense)
+        {
+            memcpy(out, dense.get() + i, Size);
+            return;
+        }
+        int bit = i * bits;
+        const uint64_t* words = &indices[bit >> 6];
+        int first = bit & 63;
+        uint64_t mask = (1ull << bits) - 1;
+        for (int z = 0; z < Size; z++)
+        {
+            int at = first + z * bits;
+            out[z] = palette[(words[at >> 6] >> (at & 63)) & mask];
+        }
+    }
+    void CopyTo(unsigned char* out) const
+    {
+        if (mode == Mode::Uniform)
+        {
+            memset(out, uniform, Volume);
+            return;
+        }
+        if (mode == Mode::Dense)
+        {
+            memcpy(out, dense.get(), Volume);
+            return;
+        }
+        for (int row = 0; row < Size * Size; row++)
+        {
+            CopyRow(row / Size, row % Size, out + row * Size);
+        }
+    }
+    void CopyTo(unsigned char out[Size][Size][Size]) const
+    {
+        CopyTo(&out[0][0][0]);
+    }
+};
+using VoxelStorage = BasicVoxelStorage<CHUNK_SHIFT>;
+
+#endif
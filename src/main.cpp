@@ -1,11 +1,15 @@
 #include "raylib.h"
 #include "raymath.h"
 #include "ChunkManager.h"
+#include "ChunkRenderer.h"
+#include "ShadowMap.h"
+#include "FrameProfiler.h"
 #include "entt/entt.hpp"
 #include "rlgl.h" 
 #include <vector>
 #include <cmath>
 #include <map>
+#include <cstring>
 
 struct PlayerTag {};
 struct PlayerConfig
@@ -32,6 +36,27 @@ struct KinematicState
     Vector3 velocity;
     bool grounded;
 };
+struct SceneShader
+{
+    Shader shader;
+    int cascadeMatrixLocs[ShadowMap::CascadeCount];
+    int cascadeBiasLoc;
+    int shadowMapLoc;
+    int lightColLoc;
+};
+static SceneShader LoadSceneShader(const char* vsFileName, const char* fsFileName)
+{
+    SceneShader scene;
+    scene.shader = ChunkRenderer::LoadChunkShader(vsFileName, fsFileName);
+    for (int c = 0; c < ShadowMap::CascadeCount; c++)
+    {
+        scene.cascadeMatrixLocs[c] = GetShaderLocation(scene.shader, TextFormat("cascadeMatrices[%d]", c));
+    }
+    scene.cascadeBiasLoc = GetShaderLocation(scene.shader, "cascadeBias");
+    scene.shadowMapLoc = GetShaderLocation(scene.shader, "shadowMap");
+    scene.lightColLoc = GetShaderLocation(scene.shader, "lightColor");
+    return scene;
+}
 static AABB GetAbsoluteBoundingBox(Vector3 pos, AABB aabb)
 {
     return AABB {Vector3Add(pos, aabb.min), Vector3Add(pos, aabb.max)};
@@ -81,64 +106,9 @@ static void UpdatePositionSystem(entt::registry& registry, float dt, ChunkManage
         {
             Vector3 movement = Vector3Scale(state.velocity, dt);
             AABB currentWorldAABB = GetAbsoluteBoundingBox(state.position, localAABB);
-            AABB nextWorldAABB = GetAbsoluteBoundingBox(Vector3Add(state.position, movement), localAABB);
-            AABB area = AABB {Vector3Min(currentWorldAABB.min, nextWorldAABB.min), Vector3Max(currentWorldAABB.max, nextWorldAABB.max)};
-            std::vector<AABB> worldAABBs;
-            const float eps = 0.01f;
-            int minX = static_cast<int>(floorf(area.min.x - eps));
-            int minY = static_cast<int>(floorf(area.min.y - eps));
-            int minZ = static_cast<int>(floorf(area.min.z - eps));
-            int maxX = static_cast<int>(ceilf(area.max.x + eps));
-            int maxY = static_cast<int>(ceilf(area.max.y + eps));
-            int maxZ = static_cast<int>(ceilf(area.max.z + eps));
-            for (int x = minX; x < maxX; x++)
-            {
-                for (int y = minY; y < maxY; y++)
-                {
-                    for (int z = minZ; z < maxZ; z++)
-                    {
-                        if (chunkManager.IsBlockAt(
-                            (float)x + 0.5f,
-                            (float)y + 0.5f,
-                            (float)z + 0.5f))
-                        {
-                            AABB blockAABB {};
-                            blockAABB.min = {(float)x, (float)y, (float)z};
-                            blockAABB.max = {(float)x + 1.0f, (float)y + 1.0f, (float)z + 1.0f};
-                            worldAABBs.push_back(blockAABB);
-                        }
-                    }
-                }
-            }
             Vector3 originalDelta = movement;
-            float* dArray = (float*)&movement;
-            int axes[3] = {1, 0, 2};
-            for (int axis : axes)
-            {
-                int a1 = (axis + 1) % 3;
-                int a2 = (axis + 2) % 3;
-                for (const auto& col : worldAABBs)
-                {
-                    const float* entMin = (float*)&currentWorldAABB.min;
-                    const float* entMax = (float*)&currentWorldAABB.max;
-                    const float* othMin = (float*)&col.min;
-                    const float* othMax = (float*)&col.max;
-                    if (entMin[a1] < othMax[a1] && entMax[a1] > othMin[a1] &&
-                        entMin[a2] < othMax[a2] && entMax[a2] > othMin[a2])
-                    {
-                        if (dArray[axis] > 0 && othMin[axis] >= entMax[axis])
-                        {
-                            float diff = othMin[axis] - entMax[axis];
-                            if (diff < dArray[axis]) dArray[axis] = diff;
-                        }
-                        else if (dArray[axis] < 0 && othMax[axis] <= entMin[axis])
-                        {
-                            float diff = othMax[axis] - entMin[axis];
-                            if (diff > dArray[axis]) dArray[axis] = diff;
-                        }
-                    }
-                }
-            }
+            VoxelAccessor voxels(chunkManager);
+            movement = ToVector3(voxels.SweepBox({ToFloat3(currentWorldAABB.min), ToFloat3(currentWorldAABB.max)}, ToFloat3(movement)));
             state.position = Vector3Add(state.position, movement);
             state.grounded = (originalDelta.y < 0 && movement.y > originalDelta.y);
             if (movement.x != originalDelta.x) state.velocity.x = 0;
@@ -146,13 +116,38 @@ static void UpdatePositionSystem(entt::registry& registry, float dt, ChunkManage
             if (movement.z != originalDelta.z) state.velocity.z = 0;
         });
 }
-int main()
+int main(int argc, char** argv)
 {
     SetConfigFlags(FLAG_WINDOW_RESIZABLE);
     InitWindow(1500, 900, "Voxel Sandbox - Debug");
     MaximizeWindow();
     ChunkManager chunkManager;
-    chunkManager.InitWorld(16, 1, 16);
+    ChunkRenderer chunkRenderer(chunkManager);
+    TerrainSettings terrain;
+    terrain.seed = 1337;
+    chunkManager.SetTerrainGenerator(TerrainGenerator::CreateDefault(terrain));
+    // The fixed 16 x 1 x 16 chunk world by default; --stream loads chunks around the player instead.
+    // --save keeps edited chunks in saves/ between runs.
+    bool streamWorld = false;
+    bool saveWorld = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--stream") == 0) streamWorld = true;
+        if (strcmp(argv[i], "--save") == 0) saveWorld = true;
+    }
+    if (saveWorld) chunkManager.EnablePersistence("saves/world_" + std::to_string(terrain.seed), false);
+    if (streamWorld)
+    {
+        StreamingSettings streaming;
+        streaming.loadRadius = 32;
+        streaming.unloadRadius = 34;
+        streaming.maxChunkY = 1;
+        chunkManager.EnableStreaming(streaming);
+    }
+    else
+    {
+        chunkManager.InitWorld(16, 1, 16);
+    }
     Camera camera = {
         .position = {0, 0, 0},
         .target = {0, 0, 1},
@@ -169,68 +164,206 @@ int main()
     registry.emplace<PlayerRotation>(player, 0.0f, 0.0f);
     registry.emplace<PlayerConfig>(player);
     registry.emplace<AABB>(player, Vector3 {0.0f, 0.0f, 0.0f}, Vector3 {0.6f, 1.8f, 0.6f});
-    Shader shadowShader = LoadShader("resources/shadow.vs", "resources/shadow.fs");
-    int shadowMapWidth = 2048;
-    int shadowMapHeight = 2048;
-    RenderTexture2D shadowMap = LoadRenderTexture(shadowMapWidth, shadowMapHeight);
-    Vector3 lightPos = {0, 150.0f, 0};
-    Camera3D lightCam = {0};
-    lightCam.position = {0, 150.0f, 0};
-    lightCam.target = {64.0f, 0.0f, 64.0f};
-    lightCam.up = {0.0f, 1.0f, 0.0f};
-    lightCam.projection = CAMERA_ORTHOGRAPHIC;
-    lightCam.fovy = 200.0f;
-    int lightMatLoc = GetShaderLocation(shadowShader, "matLight");
-    int lightPosLoc = GetShaderLocation(shadowShader, "lightPos");
-    int shadowMapLoc = GetShaderLocation(shadowShader, "shadowMap");
-    int lightColLoc = GetShaderLocation(shadowShader, "lightColor");
+    // Indexed by VertexFormat: while a format switch remeshes, chunks of both formats are drawn.
+    SceneShader shadowScenes[2] = {
+        LoadSceneShader("resources/shadow.vs", "resources/shadow.fs"),
+        LoadSceneShader("resources/shadow_packed.vs", "resources/shadow.fs")};
+    SceneShader voxelScenes[2] = {
+        LoadSceneShader("resources/shadow.vs", "resources/voxel_light.fs"),
+        LoadSceneShader("resources/shadow_packed.vs", "resources/voxel_light.fs")};
+    bool voxelLighting = false;
+    unsigned char placeBlock = BlockStone;
+    ShadowMap shadowMap;
+    shadowMap.Load(1024);
+    const Vector3 lightDirection = {64.0f, -150.0f, 64.0f};
     Vector3 lightColor = {0.8f, 0.8f, 0.8f};
+    const double meshUploadBudgetMs = 2.0;
+    FrameProfiler profiler;
     while (!WindowShouldClose())
     {
+        profiler.BeginFrame();
         float dt = GetFrameTime();
         if (IsKeyPressed(KEY_R))
         {
             registry.get<KinematicState>(player).position = {1, 32, 1};
         }
-        UpdatePlayerRotationSystem(registry);
-        UpdatePlayerVelocitySystem(registry, dt);
-        UpdatePositionSystem(registry, dt, chunkManager);
+        if (IsKeyPressed(KEY_G))
+        {
+            bool greedy = chunkManager.GetMeshingMode() == MeshingMode::Greedy;
+            chunkManager.SetMeshingMode(greedy ? MeshingMode::Naive : MeshingMode::Greedy);
+        }
+        if (IsKeyPressed(KEY_V))
+        {
+            bool packed = chunkManager.GetVertexFormat() == VertexFormat::Packed;
+            chunkManager.SetVertexFormat(packed ? VertexFormat::Standard : VertexFormat::Packed);
+        }
+        if (IsKeyPressed(KEY_B))
+        {
+            chunkRenderer.SetBatchedDraws(!chunkRenderer.GetBatchedDraws());
+        }
+        if (IsKeyPressed(KEY_O))
+        {
+            chunkManager.SetOcclusionCulling(!chunkManager.GetOcclusionCulling());
+        }
+        if (IsKeyPressed(KEY_L))
+        {
+            voxelLighting = !voxelLighting;
+        }
+        if (IsKeyPressed(KEY_ONE)) placeBlock = BlockStone;
+        if (IsKeyPressed(KEY_TWO)) placeBlock = BlockLamp;
+        if (IsKeyPressed(KEY_F3))
+        {
+            profiler.ToggleOverlay();
+        }
+        if (IsKeyPressed(KEY_F4))
+        {
+            if (profiler.IsRecording()) profiler.StopCsv();
+            else profiler.StartCsv("frame_profile.csv");
+        }
+        bool packedVertices = chunkManager.GetVertexFormat() == VertexFormat::Packed;
+        const SceneShader* scenes = voxelLighting ? voxelScenes : shadowScenes;
+        {
+            auto timer = profiler.Measure(ProfilePhase::Uploads);
+            UploadStats uploads = chunkRenderer.ProcessUploads(meshUploadBudgetMs);
+            profiler.Count(ProfileCounter::ChunksMeshed, uploads.meshes);
+            profiler.Count(ProfileCounter::BytesUploaded, (long long)uploads.bytes);
+        }
         auto& pState = registry.get<KinematicState>(player);
+        {
+            auto timer = profiler.Measure(ProfilePhase::Systems);
+            UpdatePlayerRotationSystem(registry);
+            UpdatePlayerVelocitySystem(registry, dt);
+            if (chunkManager.IsColumnLoaded(pState.position.x, pState.position.z))
+            {
+                UpdatePositionSystem(registry, dt, chunkManager);
+            }
+        }
         auto& pRot = registry.get<PlayerRotation>(player);
         camera.position = Vector3Add(pState.position, {0.3f, 1.6f, 0.3f});
         camera.target = Vector3Add(camera.position, Vector3RotateByQuaternion({0, 0, 1}, QuaternionFromEuler(pRot.pitch, pRot.yaw, 0.0f)));
-        BeginTextureMode(shadowMap);
-        ClearBackground(WHITE);
-        BeginMode3D(lightCam);
-        Matrix lightView = rlGetMatrixModelview();
-        Matrix lightProj = rlGetMatrixProjection();
-        Matrix matLight = MatrixMultiply(lightView, lightProj);
-        chunkManager.DrawWorld();
-        EndMode3D();
-        EndTextureMode();
-        BeginDrawing();
-        ClearBackground(SKYBLUE);
-        SetShaderValueMatrix(shadowShader, lightMatLoc, matLight);
-        SetShaderValue(shadowShader, lightPosLoc, &lightPos, SHADER_UNIFORM_VEC3);
-        SetShaderValue(shadowShader, lightColLoc, &lightColor, SHADER_UNIFORM_VEC3);
-        rlActiveTextureSlot(1);
-        rlEnableTexture(shadowMap.depth.id);
-        SetShaderValue(shadowShader, shadowMapLoc, (int[1])  1, SHADER_UNIFORM_INT);
-        BeginMode3D(camera);
-        chunkManager.DrawWorld(shadowShader);
-        EndMode3D();
-        auto& pPos = registry.get<KinematicState>(player).position;
-        const char* coordsText = TextFormat("X: %.2f\nY: %.2f\nZ: %.2f", pPos.x, pPos.y, pPos.z);
-        int fontSize = 20;
-        int textWidth = MeasureText("X: 0000.00", fontSize);
-        int padding = 20;
-        DrawRectangle(GetScreenWidth() - textWidth - padding, padding - 5, textWidth + 10, 75, ColorAlpha(BLACK, 0.3f));
-        DrawText(coordsText, GetScreenWidth() - textWidth - padding + 5, padding, fontSize, WHITE);
-        DrawFPS(10, 10);
-        EndDrawing();
+        VoxelRayHit target;
+        {
+            auto timer = profiler.Measure(ProfilePhase::Systems);
+            target = chunkManager.Raycast(ToFloat3(camera.position), ToFloat3(Vector3Subtract(camera.target, camera.position)), 6.0f);
+            if (target.hit && IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+            {
+                chunkManager.SetBlockAt(target.x, target.y, target.z, BlockAir);
+            }
+            if (target.hit && IsMouseButtonPressed(MOUSE_BUTTON_RIGHT))
+            {
+                int px = target.x + (int)target.normal.x;
+                int py = target.y + (int)target.normal.y;
+                int pz = target.z + (int)target.normal.z;
+                AABB body = GetAbsoluteBoundingBox(pState.position, registry.get<AABB>(player));
+                bool overlapsPlayer = body.min.x < px + 1 && body.max.x > px && body.min.y < py + 1 && body.max.y > py && body.min.z < pz + 1 && body.max.z > pz;
+                if (!overlapsPlayer) chunkManager.SetBlockAt(px, py, pz, placeBlock);
+            }
+        }
+        {
+            auto timer = profiler.Measure(ProfilePhase::Streaming);
+            chunkManager.UpdateStreaming(ToFloat3(pState.position), ToFloat3(Vector3Subtract(camera.target, camera.position)));
+        }
+        {
+            auto timer = profiler.Measure(ProfilePhase::Remesh);
+            UploadStats rebuilt = chunkRenderer.RemeshDirtyChunks();
+            profiler.Count(ProfileCounter::ChunksMeshed, rebuilt.meshes);
+            profiler.Count(ProfileCounter::BytesUploaded, (long long)rebuilt.bytes);
+        }
+        ShadowStats shadowStats;
+        if (voxelLighting)
+        {
+            shadowMap.Skip(chunkRenderer);
+        }
+        else
+        {
+            auto timer = profiler.Measure(ProfilePhase::Shadow);
+            shadowStats = shadowMap.Update(chunkRenderer, camera, (float)GetScreenWidth() / GetScreenHeight(), lightDirection);
+            profiler.Count(ProfileCounter::DrawCalls, shadowStats.draw.drawCalls);
+            profiler.Count(ProfileCounter::Triangles, shadowStats.draw.triangles);
+        }
+        DrawStats mainDraw;
+        {
+            auto timer = profiler.Measure(ProfilePhase::MainPass);
+            BeginDrawing();
+            ClearBackground(SKYBLUE);
+            float cascadeBias[ShadowMap::CascadeCount];
+            for (int c = 0; c < ShadowMap::CascadeCount; c++) cascadeBias[c] = shadowMap.GetDepthBias(c);
+            int shadowMapSlot = 1;
+            for (int f = 0; f < 2; f++)
+            {
+                const SceneShader& scene = scenes[f];
+                SetShaderValue(scene.shader, scene.lightColLoc, &lightColor, SHADER_UNIFORM_VEC3);
+                if (voxelLighting) continue;
+                for (int c = 0; c < ShadowMap::CascadeCount; c++)
+                {
+                    SetShaderValueMatrix(scene.shader, scene.cascadeMatrixLocs[c], shadowMap.GetLightMatrix(c));
+                }
+                SetShaderValueV(scene.shader, scene.cascadeBiasLoc, cascadeBias, SHADER_UNIFORM_FLOAT, ShadowMap::CascadeCount);
+                SetShaderValue(scene.shader, scene.shadowMapLoc, &shadowMapSlot, SHADER_UNIFORM_INT);
+            }
+            if (!voxelLighting)
+            {
+                rlActiveTextureSlot(1);
+                rlEnableTexture(shadowMap.GetDepthTexture().id);
+            }
+            BeginMode3D(camera);
+            Matrix matCamera = MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
+            Frustum cameraFrustum = FrustumFromMatrix(matCamera);
+            chunkManager.UpdateOcclusion(ToFloat3(camera.position), cameraFrustum);
+            mainDraw = chunkRenderer.DrawWorld(cameraFrustum, scenes[0].shader, scenes[1].shader);
+            if (target.hit) DrawCubeWires({target.x + 0.5f, target.y + 0.5f, target.z + 0.5f}, 1.01f, 1.01f, 1.01f, BLACK);
+            EndMode3D();
+            profiler.Count(ProfileCounter::DrawCalls, mainDraw.drawCalls);
+            profiler.Count(ProfileCounter::Triangles, mainDraw.triangles);
+        }
+        {
+            auto timer = profiler.Measure(ProfilePhase::Hud);
+            auto& pPos = registry.get<KinematicState>(player).position;
+            const char* coordsText = TextFormat("X: %.2f\nY: %.2f\nZ: %.2f", pPos.x, pPos.y, pPos.z);
+            int fontSize = 20;
+            int textWidth = MeasureText("X: 0000.00", fontSize);
+            int padding = 20;
+            DrawRectangle(GetScreenWidth() - textWidth - padding, padding - 5, textWidth + 10, 75, ColorAlpha(BLACK, 0.3f));
+            DrawText(coordsText, GetScreenWidth() - textWidth - padding + 5, padding, fontSize, WHITE);
+            DrawFPS(10, 10);
+            MeshStats meshStats = chunkRenderer.GetMeshStats();
+            VoxelMemoryStats voxelStats = chunkManager.GetVoxelMemoryStats();
+            size_t voxelBytes = voxelStats.bytes[0] + voxelStats.bytes[1] + voxelStats.bytes[2];
+            const char* mesherName = chunkManager.GetMeshingMode() == MeshingMode::Greedy ? "Greedy" : "Naive";
+            const char* formatName = packedVertices ? "Packed" : "Standard";
+            const char* shadowNames[] = {"cached", "partial", "full"};
+            const char* shadowState = voxelLighting ? "off" : shadowNames[(int)shadowStats.redraw];
+            int hudY = 40;
+            const int lineHeight = 22;
+            DrawText(TextFormat("Mesher [G]: %s  Profiler [F3]  CSV [F4]: %s", mesherName, profiler.IsRecording() ? "recording" : "off"), 10, hudY, 20, WHITE);
+            hudY += lineHeight;
+            DrawText(TextFormat("Vertices [V]: %s  Batching [B]: %s  Occlusion [O]: %s  Lighting [L]: %s  Place [1/2]: %s", formatName, chunkRenderer.GetBatchedDraws() ? "on" : "off", chunkManager.GetOcclusionCulling() ? "on" : "off", voxelLighting ? "voxel" : "shadow map", placeBlock == BlockLamp ? "Lamp" : "Stone"), 10, hudY, 20, WHITE);
+            hudY += lineHeight;
+            DrawText(TextFormat("Verts: %d  Tris: %d", meshStats.vertexCount, meshStats.triangleCount), 10, hudY, 20, WHITE);
+            hudY += lineHeight;
+            DrawText(TextFormat("GPU: %.2f MB  Build: %.1f ms  Pending: %d", meshStats.gpuBytes / (1024.0 * 1024.0), meshStats.buildMilliseconds, meshStats.pendingMeshes), 10, hudY, 20, WHITE);
+            hudY += lineHeight;
+            DrawText(TextFormat("Chunks: %d (LOD %d/%d/%d, %.1f MB voxels, %.1f MB light, %d uniform, %d palette, %d dense, %d unmeshed)  Disk: %d loaded, %d saving", meshStats.loadedChunks, meshStats.lodChunks[0], meshStats.lodChunks[1], meshStats.lodChunks[2], voxelBytes / (1024.0 * 1024.0), voxelStats.lightBytes / (1024.0 * 1024.0), voxelStats.chunks[0], voxelStats.chunks[1], voxelStats.chunks[2], voxelStats.skippedMeshes, meshStats.chunksFromDisk, meshStats.pendingSaves), 10, hudY, 20, WHITE);
+            hudY += lineHeight;
+            DrawText(TextFormat("Drawn: %d  Culled: %d  Occluded: %d  Empty: %d  Calls: %d", mainDraw.visibleChunks, mainDraw.culledChunks, mainDraw.occludedChunks, mainDraw.emptyChunks, mainDraw.drawCalls), 10, hudY, 20, WHITE);
+            hudY += lineHeight;
+            DrawText(TextFormat("Shadow: %s, %d chunks, %.1f%% texels", shadowState, shadowStats.draw.visibleChunks, shadowStats.redrawnTexels * 100.0 / shadowMap.GetTexelCount()), 10, hudY, 20, WHITE);
+            profiler.DrawOverlay(10, 200);
+        }
+        {
+            auto timer = profiler.Measure(ProfilePhase::Present);
+            EndDrawing();
+        }
+        profiler.EndFrame();
+    }
+    for (int f = 0; f < 2; f++)
+    {
+        UnloadShader(shadowScenes[f].shader);
+        UnloadShader(voxelScenes[f].shader);
     }
-    UnloadShader(shadowShader);
-    UnloadRenderTexture(shadowMap);
+    shadowMap.Unload();
+    chunkRenderer.Unload();
+    chunkManager.Shutdown();
     CloseWindow();
     return 0;
 }